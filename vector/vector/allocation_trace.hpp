@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stl_compatible {
+
+	enum class trace_event : std::uint8_t { allocate, deallocate, resize };
+
+	struct trace_record {
+
+		std::uint64_t time;
+		std::uint64_t address;
+		std::uint64_t size;
+		std::uint32_t thread;
+		std::uint16_t alignment;
+		trace_event event;
+		std::uint8_t reserved;
+	};
+
+	static_assert(sizeof(trace_record) == 32, "trace records must stay 32 bytes");
+
+	class allocation_recorder {
+	public:
+		static constexpr char magic[8] = { 'V', 'E', 'C', 'T', 'R', 'A', 'C', 'E' };
+		static const std::size_t buffered_records = 4096;
+
+		~allocation_recorder();
+
+		void start(std::ostream& out);
+		void stop();
+		bool recording() const noexcept { return active.load(std::memory_order_relaxed); };
+		void record(trace_event event, const void* p, std::size_t n, std::size_t alignment);
+
+		static std::uint32_t thread_index();
+
+	private:
+		std::atomic<bool> active{ false };
+		std::mutex mutex;
+		std::ostream* out = nullptr;
+		std::vector<trace_record> buffer;
+		std::chrono::steady_clock::time_point origin;
+
+		void flush();
+	};
+
+	inline allocation_recorder& allocation_trace() {
+		static allocation_recorder recorder;
+		return recorder;
+	}
+
+	std::vector<trace_record> read_trace(std::istream& in);
+
+	struct replay_result {
+
+		double seconds;
+		double fragmentation;
+	};
+
+	template<typename Pool>
+	replay_result replay(const std::vector<trace_record>& trace, Pool& pool);
+
+	inline allocation_recorder::~allocation_recorder() {
+		stop();
+	}
+
+	inline std::uint32_t allocation_recorder::thread_index() {
+		static std::atomic<std::uint32_t> next{ 0 };
+		static thread_local std::uint32_t index = next++;
+		return index;
+	}
+
+	inline void allocation_recorder::start(std::ostream& out) {
+		stop();
+		std::lock_guard<std::mutex> lock(mutex);
+		this->out = &out;
+		out.write(magic, sizeof(magic));
+		origin = std::chrono::steady_clock::now();
+		active.store(true, std::memory_order_relaxed);
+	}
+
+	inline void allocation_recorder::stop() {
+		active.store(false, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock(mutex);
+		if (out == nullptr) return;
+		flush();
+		out->flush();
+		out = nullptr;
+	}
+
+	inline void allocation_recorder::record(trace_event event, const void* p, std::size_t n, std::size_t alignment) {
+		auto now = std::chrono::steady_clock::now();
+		std::uint32_t thread = thread_index();
+		std::lock_guard<std::mutex> lock(mutex);
+		if (out == nullptr) return;
+		std::uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(now, origin) - origin).count();
+		buffer.push_back({ time, reinterpret_cast<std::uintptr_t>(p), n, thread, static_cast<std::uint16_t>(alignment), event, 0 });
+		if (buffer.size() >= buffered_records) flush();
+	}
+
+	inline void allocation_recorder::flush() {
+		if (!buffer.empty()) out->write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(trace_record));
+		buffer.clear();
+	}
+
+	inline std::vector<trace_record> read_trace(std::istream& in) {
+		char header[sizeof(allocation_recorder::magic)];
+		if (!in.read(header, sizeof(header)) || std::memcmp(header, allocation_recorder::magic, sizeof(header)) != 0)
+			throw std::runtime_error("not an allocation trace");
+		std::vector<trace_record> trace;
+		trace_record record;
+		while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) trace.push_back(record);
+		return trace;
+	}
+
+	template<typename Pool>
+	replay_result replay(const std::vector<trace_record>& trace, Pool& pool) {
+		std::unordered_map<std::uint64_t, std::pair<typename Pool::pointer, std::uint64_t>> live;
+		std::uint64_t live_bytes = 0, peak = 0;
+		bool at_peak = false;
+		double fragmentation = 0.0;
+		std::chrono::steady_clock::duration sampling{ 0 };
+		auto sample = [&]() {
+			auto start = std::chrono::steady_clock::now();
+			fragmentation = pool.fragmentation();
+			at_peak = false;
+			sampling += std::chrono::steady_clock::now() - start;
+		};
+		auto begin = std::chrono::steady_clock::now();
+		for (auto& record : trace) {
+			if (record.event == trace_event::allocate) {
+				live[record.address] = std::make_pair(pool.allocate(record.size, record.alignment), record.size);
+				if ((live_bytes += record.size) > peak) peak = live_bytes, at_peak = true;
+				continue;
+			}
+			auto found = live.find(record.address);
+			if (found == live.end()) continue;
+			auto& block = found->second;
+			if (at_peak && (record.event == trace_event::deallocate || record.size < block.second)) sample();
+			live_bytes = live_bytes - block.second + (record.event == trace_event::resize ? record.size : 0);
+			if (live_bytes > peak) peak = live_bytes, at_peak = true;
+			if (record.event == trace_event::resize) {
+				bool in_place = record.size > block.second ? pool.expand(block.first, record.size) : pool.shrink(block.first, record.size);
+				if (!in_place) {
+					typename Pool::pointer moved = pool.allocate(record.size, record.alignment);
+					pool.deallocate(block.first, block.second);
+					block.first = moved;
+				}
+				block.second = record.size;
+				continue;
+			}
+			pool.deallocate(block.first, block.second);
+			live.erase(found);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin - sampling).count();
+		if (at_peak) sample();
+		for (auto& block : live) pool.deallocate(block.second.first, block.second.second);
+		return { seconds, fragmentation };
+	}
+
+}
\ No newline at end of file
@@ -1,120 +1,1029 @@
 #pragma once
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "arena_provider.hpp"
+#include "pool_stats.hpp"
+#include "allocation_trace.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef STL_COMPATIBLE_POOL_SIZE
+#define STL_COMPATIBLE_POOL_SIZE (std::size_t(1) << 24)
+#endif
 
 namespace stl_compatible {
 
-	template<typename T>
-	class allocator;
+	inline std::size_t configured_pool_size() {
+		static const std::size_t size = [] {
+			const char* value = std::getenv("STL_COMPATIBLE_POOL_SIZE");
+			char* suffix = nullptr;
+			unsigned long long n = value == nullptr ? 0 : std::strtoull(value, &suffix, 10);
+			if (n == 0) return std::size_t(STL_COMPATIBLE_POOL_SIZE);
+			switch (*suffix) {
+			case 'k': case 'K': n <<= 10; break;
+			case 'm': case 'M': n <<= 20; break;
+			case 'g': case 'G': n <<= 30; break;
+			}
+			return std::size_t(n);
+		}();
+		return size;
+	}
 
-	template<typename T>
-	struct memory_pool {
+	struct remote_free_queue {
+
+		struct remote_block {
+
+			remote_block* next;
+			std::size_t length;
+		};
+
+		std::atomic<remote_block*> remote_frees{ nullptr };
+
+		bool can_defer(void* p, std::size_t n) const;
+		void defer_deallocate(void* p, std::size_t n);
+		remote_block* take_remote_frees();
+
+		template<typename Pool>
+		void drain(Pool& pool);
+	};
+
+	struct null_mutex {
+
+		void lock() {};
+		void unlock() {};
+		bool try_lock() { return true; };
+	};
+
+	enum class fit_policy { size_classes, best_fit };
+
+	struct memory_pool : remote_free_queue, stats_source {
+
+		typedef char* pointer;
+		typedef std::size_t size_type;
+		typedef std::mutex mutex_type;
+
+		struct alignas(std::max_align_t) block_header {
+
+			size_type previous;
+			size_type length;
+
+			bool is_free() const { return (length & 1) != 0; };
+			size_type size() const { return length & ~size_type(1); };
+			pointer data() { return reinterpret_cast<pointer>(this) + sizeof(block_header); };
+			block_header* next() { return reinterpret_cast<block_header*>(reinterpret_cast<pointer>(this) + size()); };
+			block_header* prev() { return reinterpret_cast<block_header*>(reinterpret_cast<pointer>(this) - previous); };
+		};
+
+		struct free_block : block_header {
+
+			free_block* prev_free;
+			free_block* next_free;
+			free_block* prev_dirty;
+			free_block* next_dirty;
+
+			free_block*& left() { return prev_free; };
+			free_block*& right() { return next_free; };
+		};
+
+		struct memory_arena {
+
+			pointer begin;
+			size_type length;
+			size_type committed;
 
-		typedef std::list<typename allocator<T>::memory_block> blocks_list;
+			memory_arena(pointer begin, size_type length)
+				: begin(begin), length(length), committed(0) {};
+		};
+
+		static const size_type size_classes = sizeof(size_type) * 8;
+		static const size_type granularity = alignof(std::max_align_t);
+		static const size_type header_size = sizeof(block_header);
+		static const size_type min_block_size = sizeof(free_block);
+		static const size_type commit_granularity = size_type(1) << 16;
 
-		blocks_list memory;
-		typename allocator<T>::pointer free_space;
-	    typename allocator<T>::size_type default_size = 1000000;
+		arena_provider& provider;
+		fit_policy placement;
+		free_block* free_blocks[size_classes] = {};
+		size_type free_classes = 0;
+		free_block* free_tree = nullptr;
+		free_block* dirty_blocks = nullptr;
+		std::vector<memory_arena> arenas;
+		size_type reserved = 0;
+		size_type default_size = configured_pool_size();
+		size_type growth_factor = 2;
+		size_type max_size = 0;
+		size_type trim_threshold = 0;
+		std::mutex mutex;
+
+		memory_pool(arena_provider& provider = default_arena_provider(), fit_policy placement = fit_policy::size_classes)
+			: provider(provider), placement(placement) {
+			registered_pools().add(this);
+		}
 
-		memory_pool() {
-			free_space = (typename allocator<T>::pointer) ::operator new(sizeof(T) * default_size);
-			memory = { typename allocator<T>::memory_block(free_space, default_size, true) };
+		~memory_pool() {
+			registered_pools().remove(this);
+			for (auto& arena : arenas) provider.release(arena.begin, arena.length);
 		}
+
+		pointer allocate(size_type n, size_type alignment = granularity);
+		void deallocate(void* p, size_type n);
+		bool expand(void* p, size_type n);
+		bool shrink(void* p, size_type n);
+		free_block* grow(size_type n);
+		size_type size_limit() const;
+		size_type trim();
+		bool owns(const void* p) const;
+		bool is_allocated(const void* p) const;
+		size_type usable_size(const void* p) const;
+		size_type block_count() const;
+
+		void drain_remote_frees();
+		double fragmentation() const;
+		pool_stats stats() override;
+		pool_stats snapshot() const override;
+
+		static size_type size_class(size_type n);
+		static size_type lowest_class(size_type classes);
+		static size_type round_up(size_type n);
+		static size_type block_length(size_type n);
+
+	private:
+		free_block* find_free(size_type length);
+		void insert_free(block_header* block);
+		void erase_free(block_header* block);
+		free_block* splay(free_block* root, size_type size, const void* address);
+		bool is_dirty(const block_header* block) const;
+		void mark_dirty(block_header* block);
+		void mark_clean(block_header* block);
+		block_header* split(block_header* block, size_type length);
+		block_header* header_of(const void* p) const;
+		memory_arena* find_arena(const void* p) const;
+		bool commit(const void* block, pointer end);
+
+		size_type untrimmed = 0;
 	};
 
-	template<typename T>
-	memory_pool<T>& alloc() {
-		static memory_pool<T> free_store;
+	template<typename Pool = memory_pool>
+	Pool& alloc() {
+		static Pool free_store;
 		return free_store;
 	}
 
-	template<typename T>
+	template<typename Pool>
+	struct slab_depot {
+
+		typedef typename Pool::pointer pointer;
+		typedef typename Pool::size_type size_type;
+
+		struct free_object {
+
+			free_object* next;
+		};
+
+		struct slab {
+
+			slab* prev;
+			slab* next;
+			free_object* free;
+			size_type used;
+			size_type size_class;
+			slab* run;
+			size_type idle_slabs;
+		};
+
+		static const size_type classes = 9;
+		static const size_type slab_size = size_type(1) << 16;
+		static const size_type run_slabs = 16;
+		static const size_type run_size = slab_size * run_slabs;
+		static const size_type header_length = (sizeof(slab) + Pool::granularity - 1) / Pool::granularity * Pool::granularity;
+
+		Pool& pool;
+		slab* partial[classes] = {};
+		slab* idle = nullptr;
+		slab* fresh = nullptr;
+		size_type fresh_slabs = 0;
+
+		slab_depot(Pool& pool = alloc<Pool>()) : pool(pool) {};
+
+		free_object* take(size_type c, size_type count, size_type& taken);
+		void give(void* p);
+
+		static size_type object_size(size_type c) { return Pool::granularity << c; };
+		static size_type capacity(size_type c) { return (slab_size - header_length) / object_size(c); };
+		static slab* slab_of(const void* p);
+
+	private:
+		slab* carve(size_type c);
+		void retire(slab* s);
+		void link(slab*& list, slab* s);
+		void unlink(slab*& list, slab* s);
+	};
+
+	template<typename Pool>
+	slab_depot<Pool>& slabs() {
+		static slab_depot<Pool> depot;
+		return depot;
+	}
+
+	template<typename Pool>
+	struct thread_cached : std::true_type {};
+
+	template<typename Pool>
+	auto attach_cache(Pool& pool, const cache_counters* cache, int) -> decltype(pool.attach_cache(cache)) {
+		return pool.attach_cache(cache);
+	}
+
+	template<typename Pool>
+	void attach_cache(Pool&, const cache_counters*, long) {}
+
+	template<typename Pool>
+	auto detach_cache(Pool& pool, const cache_counters* cache, int) -> decltype(pool.detach_cache(cache)) {
+		return pool.detach_cache(cache);
+	}
+
+	template<typename Pool>
+	void detach_cache(Pool&, const cache_counters*, long) {}
+
+	template<typename Pool>
+	struct thread_cache {
+
+		typedef typename Pool::pointer pointer;
+		typedef typename Pool::size_type size_type;
+		typedef typename slab_depot<Pool>::free_object free_object;
+
+		static const size_type cached_classes = slab_depot<Pool>::classes;
+		static const size_type batch_size = 16;
+
+		Pool& pool = alloc<Pool>();
+		slab_depot<Pool>& depot = slabs<Pool>();
+		free_object* blocks[cached_classes] = {};
+		size_type counts[cached_classes] = {};
+		cache_counters counters;
+
+		thread_cache();
+		~thread_cache();
+
+		pointer allocate(size_type n);
+		void deallocate(void* p, size_type n);
+
+		static bool is_cached(size_type n);
+		static size_type cached_class(size_type n);
+		static bool& destroyed();
+
+	private:
+		void refill(size_type c);
+		void flush(size_type c, size_type count);
+	};
+
+	template<typename Pool>
+	thread_cache<Pool>& local_cache() {
+		static thread_local thread_cache<Pool> cache;
+		return cache;
+	}
+
+	template<typename Pool>
+	typename Pool::pointer cached_allocate(typename Pool::size_type n) {
+		if (!thread_cache<Pool>::destroyed()) return local_cache<Pool>().allocate(n);
+		typename Pool::size_type taken = 0;
+		std::lock_guard<typename Pool::mutex_type> lock(alloc<Pool>().mutex);
+		return reinterpret_cast<typename Pool::pointer>(slabs<Pool>().take(thread_cache<Pool>::cached_class(n), 1, taken));
+	}
+
+	template<typename Pool>
+	void cached_deallocate(void* p, typename Pool::size_type n) {
+		if (!thread_cache<Pool>::destroyed()) return local_cache<Pool>().deallocate(p, n);
+		std::lock_guard<typename Pool::mutex_type> lock(alloc<Pool>().mutex);
+		slabs<Pool>().give(p);
+	}
+
+	const std::size_t cache_line_size = 64;
+
+	template<typename T, std::size_t Alignment = alignof(T), typename Pool = memory_pool>
 	class allocator {
 	public:
 		typedef T value_type;
 		typedef T* pointer;
 		typedef T& reference;
 		typedef size_t size_type;
+		typedef std::false_type propagate_on_container_copy_assignment;
+		typedef std::false_type propagate_on_container_move_assignment;
+		typedef std::false_type propagate_on_container_swap;
+		typedef std::false_type is_always_equal;
+
+		static const size_type alignment = Alignment > alignof(T) ? Alignment : alignof(T);
+		static_assert((alignment & (alignment - 1)) == 0, "alignment must be a power of two");
 
-		allocator() {};
-		allocator(const allocator<T>&) {};
 		template<typename U>
-		allocator(const allocator<U>&) {};
+		struct rebind {
+			typedef allocator<U, Alignment, Pool> other;
+		};
+
+		allocator() : _memory(&alloc<Pool>()) {};
+		allocator(Pool& pool) : _memory(&pool) {};
+		template<typename U, std::size_t B>
+		allocator(const allocator<U, B, Pool>& other) : _memory(&other.pool()) {};
 
-		allocator<T>& operator=(const allocator<T>&) { return *this; };
 		pointer allocate(size_type n);
 		void deallocate(pointer p, size_type n);
+		bool try_expand(pointer p, size_type old_n, size_type new_n);
+		bool try_shrink(pointer p, size_type old_n, size_type new_n);
 		void destroy(pointer p);
+		Pool& pool() const { return *_memory; };
 
 		template <typename... Types>
 		void construct(pointer p, Types&&... t) {
 			::new (static_cast<void*>(p)) value_type(std::forward<Types>(t)...);
 		};
 
-		struct memory_block {
-
-			pointer begin;
-			size_type length;
-			bool is_free;
-
-			memory_block(pointer begin, size_type length, bool is_free)
-				: begin(begin), length(length), is_free(is_free) {};
-		};
-
 	private:
-		memory_pool<T>& _memory = alloc<T>();
+		Pool* _memory;
+
+		bool is_cached(size_type bytes) const;
 	};
 
 	template<typename T>
-	void allocator<T>::destroy(pointer p) { p->~value_type(); };
+	using cache_aligned_allocator = allocator<T, cache_line_size>;
 
-	template<typename T>
-	typename allocator<T>::pointer allocator<T>::allocate(size_type n) {
-		for (auto it = _memory.memory.rbegin(); it != _memory.memory.rend(); ++it) {
-			if (it->is_free && it->length == n) {
-				it->is_free = false;
-				return it->begin;
+	inline memory_pool::size_type memory_pool::size_class(size_type n) {
+		size_type c = 0;
+		while (n >>= 1) ++c;
+		return c;
+	}
+
+	inline memory_pool::size_type memory_pool::lowest_class(size_type classes) {
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long c;
+		_BitScanForward64(&c, classes);
+		return c;
+#elif defined(_MSC_VER)
+		unsigned long c;
+		_BitScanForward(&c, classes);
+		return c;
+#else
+		return __builtin_ctzll(classes);
+#endif
+	}
+
+	inline memory_pool::size_type memory_pool::round_up(size_type n) {
+		if (n == 0) return granularity;
+		return (n + granularity - 1) & ~(granularity - 1);
+	}
+
+	inline memory_pool::size_type memory_pool::block_length(size_type n) {
+		return std::max(round_up(n) + header_size, size_type(min_block_size));
+	}
+
+	inline void memory_pool::insert_free(block_header* block) {
+		free_block* f = static_cast<free_block*>(block);
+		block->length |= 1;
+		f->prev_dirty = f->next_dirty = nullptr;
+		++counters.free_blocks;
+		if (placement == fit_policy::best_fit) {
+			f->left() = f->right() = nullptr;
+			if (free_tree != nullptr) {
+				free_block* root = splay(free_tree, f->size(), f);
+				if (f->size() < root->size() || (f->size() == root->size() && f < root)) {
+					f->left() = root->left();
+					f->right() = root;
+					root->left() = nullptr;
+				}
+				else {
+					f->right() = root->right();
+					f->left() = root;
+					root->right() = nullptr;
+				}
 			}
-			else if (it->is_free && it->length > n) {
-				auto block = it.base();
-				auto res = _memory.memory.emplace(--block, it->begin, n, false);
-				it->begin = it->begin + n;
-				it->length = it->length - n;
-				return res->begin;
+			free_tree = f;
+			return;
+		}
+		size_type c = size_class(block->size());
+		free_block*& bucket = free_blocks[c];
+		f->prev_free = nullptr;
+		f->next_free = bucket;
+		if (bucket != nullptr) bucket->prev_free = f;
+		bucket = f;
+		free_classes |= size_type(1) << c;
+	}
+
+	inline void memory_pool::erase_free(block_header* block) {
+		free_block* f = static_cast<free_block*>(block);
+		mark_clean(block);
+		block->length &= ~size_type(1);
+		--counters.free_blocks;
+		if (placement == fit_policy::best_fit) {
+			free_tree = splay(free_tree, f->size(), f);
+			if (f->left() == nullptr) free_tree = f->right();
+			else {
+				free_tree = splay(f->left(), f->size(), f);
+				free_tree->right() = f->right();
 			}
+			return;
 		}
-		throw std::bad_alloc();
-	};
+		size_type c = size_class(block->size());
+		if (f->prev_free != nullptr) f->prev_free->next_free = f->next_free;
+		else if ((free_blocks[c] = f->next_free) == nullptr) free_classes &= ~(size_type(1) << c);
+		if (f->next_free != nullptr) f->next_free->prev_free = f->prev_free;
+	}
 
-	template<typename T>
-	void allocator<T>::deallocate(pointer p, size_type n) {
-		if (p == nullptr) return;
-		for (auto it = _memory.memory.begin(); it != _memory.memory.end(); ++it) {
-			if (it->begin == p && it->length == n) {
-				it->is_free = true;
-				if (it != _memory.memory.begin()) {
-					auto buff = it;
-					for (--buff; buff != _memory.memory.begin();) {
-						if (!buff->is_free) break;
-						it->begin = buff->begin;
-						it->length = it->length + buff->length;
-						buff = _memory.memory.erase(buff);
-						--buff;
-					}
+	inline bool memory_pool::is_dirty(const block_header* block) const {
+		const free_block* f = static_cast<const free_block*>(block);
+		return f->prev_dirty != nullptr || dirty_blocks == f;
+	}
+
+	inline void memory_pool::mark_dirty(block_header* block) {
+		free_block* f = static_cast<free_block*>(block);
+		if (is_dirty(f)) return;
+		f->next_dirty = dirty_blocks;
+		if (dirty_blocks != nullptr) dirty_blocks->prev_dirty = f;
+		dirty_blocks = f;
+	}
+
+	inline void memory_pool::mark_clean(block_header* block) {
+		free_block* f = static_cast<free_block*>(block);
+		if (!is_dirty(f)) return;
+		if (f->prev_dirty != nullptr) f->prev_dirty->next_dirty = f->next_dirty;
+		else dirty_blocks = f->next_dirty;
+		if (f->next_dirty != nullptr) f->next_dirty->prev_dirty = f->prev_dirty;
+		f->prev_dirty = f->next_dirty = nullptr;
+	}
+
+	inline memory_pool::free_block* memory_pool::splay(free_block* root, size_type size, const void* address) {
+		free_block side;
+		side.left() = side.right() = nullptr;
+		free_block* left = &side, *right = &side;
+		for (;;) {
+			if (size < root->size() || (size == root->size() && address < root)) {
+				free_block* child = root->left();
+				if (child == nullptr) break;
+				if (size < child->size() || (size == child->size() && address < child)) {
+					root->left() = child->right();
+					child->right() = root;
+					root = child;
+					if (root->left() == nullptr) break;
 				}
-				auto buff = it;
-				for (++buff; buff != _memory.memory.end();) {
-					if (!buff->is_free) break;
-					it->length = it->length + buff->length;
-					buff = _memory.memory.erase(buff);
+				right->left() = root;
+				right = root;
+				root = root->left();
+			}
+			else if (size > root->size() || (size == root->size() && address > root)) {
+				free_block* child = root->right();
+				if (child == nullptr) break;
+				if (size > child->size() || (size == child->size() && address > child)) {
+					root->right() = child->left();
+					child->left() = root;
+					root = child;
+					if (root->right() == nullptr) break;
 				}
+				left->right() = root;
+				left = root;
+				root = root->right();
 			}
+			else break;
 		}
+		left->right() = root->left();
+		right->left() = root->right();
+		root->left() = side.right();
+		root->right() = side.left();
+		return root;
+	}
+
+	inline memory_pool::block_header* memory_pool::split(block_header* block, size_type length) {
+		block_header* tail = reinterpret_cast<block_header*>(reinterpret_cast<pointer>(block) + length);
+		tail->previous = length;
+		tail->length = block->size() - length;
+		tail->next()->previous = tail->size();
+		block->length = length;
+		return tail;
+	}
+
+	inline memory_pool::free_block* memory_pool::find_free(size_type length) {
+		if (placement == fit_policy::best_fit) {
+			if (free_tree == nullptr) return nullptr;
+			free_tree = splay(free_tree, length, nullptr);
+			if (free_tree->size() >= length) return free_tree;
+			free_block* f = free_tree->right();
+			if (f != nullptr)
+				while (f->left() != nullptr) f = f->left();
+			return f;
+		}
+		size_type c = size_class(length);
+		if (free_blocks[c] != nullptr && free_blocks[c]->size() >= length) return free_blocks[c];
+		size_type larger = c + 1 < size_classes ? free_classes >> (c + 1) << (c + 1) : 0;
+		if (larger != 0) return free_blocks[lowest_class(larger)];
+		for (free_block* f = free_blocks[c]; f != nullptr; f = f->next_free)
+			if (f->size() >= length) return f;
+		return nullptr;
+	}
+
+	inline memory_pool::free_block* memory_pool::grow(size_type n) {
+		size_type limit = size_limit();
+		if (reserved > limit || limit - reserved < header_size || n > limit - reserved - header_size) throw std::bad_alloc();
+		size_type length = std::max(n + header_size, arenas.empty() ? default_size : arenas.back().length * growth_factor);
+		length = std::min(length, limit - reserved);
+		pointer begin = static_cast<pointer>(provider.reserve(length));
+		size_type usable = (length - header_size) & ~(granularity - 1);
+		arenas.emplace_back(begin, length);
+		if (!commit(begin, begin + min_block_size) || !provider.commit(begin + usable, header_size)) {
+			arenas.pop_back();
+			provider.release(begin, length);
+			throw std::bad_alloc();
+		}
+		reserved += length;
+		block_header* block = reinterpret_cast<block_header*>(begin);
+		block->previous = 0;
+		block->length = usable;
+		block_header* fence = block->next();
+		fence->previous = usable;
+		fence->length = 0;
+		insert_free(block);
+		return static_cast<free_block*>(block);
+	}
+
+	inline memory_pool::size_type memory_pool::size_limit() const {
+		if (max_size != 0) return max_size;
+		return default_size > size_type(-1) / 2048 ? size_type(-1) / 2 : default_size * 1024;
+	}
+
+	inline memory_pool::memory_arena* memory_pool::find_arena(const void* p) const {
+		for (auto& arena : arenas)
+			if (static_cast<const char*>(p) >= arena.begin && static_cast<const char*>(p) < arena.begin + arena.length) return const_cast<memory_arena*>(&arena);
+		return nullptr;
+	}
+
+	inline bool memory_pool::owns(const void* p) const {
+		return find_arena(p) != nullptr;
+	}
+
+	inline memory_pool::block_header* memory_pool::header_of(const void* p) const {
+		if (p == nullptr || reinterpret_cast<std::uintptr_t>(p) % granularity != 0) return nullptr;
+		memory_arena* arena = find_arena(p);
+		if (arena == nullptr || size_type(static_cast<const char*>(p) - arena->begin) < header_size) return nullptr;
+		block_header* block = reinterpret_cast<block_header*>(const_cast<char*>(static_cast<const char*>(p)) - header_size);
+		if (block->is_free() || block->size() < min_block_size || block->size() > size_type(arena->begin + arena->length - reinterpret_cast<pointer>(block))) return nullptr;
+		return block->next()->previous == block->size() ? block : nullptr;
+	}
+
+	inline bool memory_pool::commit(const void* block, pointer end) {
+		memory_arena& arena = *find_arena(block);
+		end = std::min(end, arena.begin + arena.length);
+		if (arena.begin + arena.committed >= end) return true;
+		size_type committed = std::min(arena.length, (end - arena.begin + commit_granularity - 1) / commit_granularity * commit_granularity);
+		if (!provider.commit(arena.begin + arena.committed, committed - arena.committed)) return false;
+		arena.committed = committed;
+		return true;
+	}
+
+	inline bool remote_free_queue::can_defer(void* p, std::size_t n) const {
+		return n >= sizeof(remote_block) && reinterpret_cast<std::uintptr_t>(p) % alignof(remote_block) == 0;
+	}
+
+	inline void remote_free_queue::defer_deallocate(void* p, std::size_t n) {
+		remote_block* block = ::new (p) remote_block{ remote_frees.load(std::memory_order_relaxed), n };
+		while (!remote_frees.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	inline remote_free_queue::remote_block* remote_free_queue::take_remote_frees() {
+		return remote_frees.exchange(nullptr, std::memory_order_acquire);
+	}
+
+	template<typename Pool>
+	void remote_free_queue::drain(Pool& pool) {
+		remote_block* block = take_remote_frees();
+		while (block != nullptr) {
+			remote_block* next = block->next;
+			pool.deallocate(block, block->length);
+			block = next;
+		}
+	}
+
+	inline void memory_pool::drain_remote_frees() {
+		drain(*this);
+	}
+
+	inline memory_pool::pointer memory_pool::allocate(size_type n, size_type alignment) {
+		if (n > size_limit()) throw std::bad_alloc();
+		size_type length = block_length(n);
+		alignment = std::max(alignment, size_type(granularity));
+		size_type padded = alignment > granularity ? length + alignment + min_block_size : length;
+		if (remote_frees.load(std::memory_order_relaxed) != nullptr) drain_remote_frees();
+		block_header* block = find_free(padded);
+		if (block == nullptr) block = grow(padded);
+		size_type offset = (alignment - reinterpret_cast<std::uintptr_t>(block->data()) % alignment) % alignment;
+		if (offset != 0 && offset < min_block_size) offset += (min_block_size - offset + alignment - 1) / alignment * alignment;
+		if (!commit(block, reinterpret_cast<pointer>(block) + offset + length + min_block_size)) throw std::bad_alloc();
+		bool dirty = is_dirty(block);
+		erase_free(block);
+		if (offset > 0) {
+			block_header* aligned = split(block, offset);
+			insert_free(block);
+			if (dirty) mark_dirty(block);
+			block = aligned;
+			++counters.splits;
+		}
+		if (block->size() - length >= min_block_size) {
+			block_header* tail = split(block, length);
+			insert_free(tail);
+			if (dirty) mark_dirty(tail);
+			++counters.splits;
+		}
+		count_allocation(block->size() - header_size);
+		return block->data();
+	}
+
+	inline void memory_pool::deallocate(void* p, size_type) {
+		block_header* block = header_of(p);
+		if (block == nullptr) return;
+		count_deallocation(block->size() - header_size);
+		untrimmed += block->size();
+		if (block->previous != 0 && block->prev()->is_free()) {
+			block_header* prev = block->prev();
+			erase_free(prev);
+			prev->length = prev->size() + block->size();
+			prev->next()->previous = prev->size();
+			block = prev;
+			++counters.coalesces;
+		}
+		block_header* next = block->next();
+		if (next->is_free()) {
+			erase_free(next);
+			block->length = block->size() + next->size();
+			block->next()->previous = block->size();
+			++counters.coalesces;
+		}
+		insert_free(block);
+		mark_dirty(block);
+		if (trim_threshold != 0 && untrimmed >= trim_threshold) trim();
+	}
+
+	inline memory_pool::size_type memory_pool::trim() {
+		size_type released = 0;
+		while (dirty_blocks != nullptr) {
+			free_block* block = dirty_blocks;
+			released += provider.purge(reinterpret_cast<pointer>(block) + min_block_size, block->size() - min_block_size);
+			mark_clean(block);
+		}
+		untrimmed = 0;
+		counters.trimmed += released;
+		return released;
+	}
+
+	inline bool memory_pool::is_allocated(const void* p) const {
+		memory_arena* arena = find_arena(p);
+		if (arena == nullptr) return false;
+		for (block_header* block = reinterpret_cast<block_header*>(arena->begin); block->size() != 0; block = block->next())
+			if (block->data() == p) return !block->is_free();
+		return false;
+	}
+
+	inline memory_pool::size_type memory_pool::usable_size(const void* p) const {
+		block_header* block = header_of(p);
+		return block == nullptr ? 0 : block->size() - header_size;
+	}
+
+	inline memory_pool::size_type memory_pool::block_count() const {
+		size_type count = 0;
+		for (auto& arena : arenas)
+			for (block_header* block = reinterpret_cast<block_header*>(arena.begin); block->size() != 0; block = block->next()) ++count;
+		return count;
+	}
+
+	inline double memory_pool::fragmentation() const {
+		size_type total = 0, largest = 0;
+		for (auto& arena : arenas)
+			for (block_header* block = reinterpret_cast<block_header*>(arena.begin); block->size() != 0; block = block->next()) {
+				if (!block->is_free()) continue;
+				total += block->size() - header_size;
+				largest = std::max(largest, block->size() - header_size);
+			}
+		return total == 0 ? 0.0 : 1.0 - double(largest) / double(total);
+	}
+
+	inline pool_stats memory_pool::stats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return snapshot();
+	}
+
+	inline pool_stats memory_pool::snapshot() const {
+		pool_stats result = counters;
+		result.reserved = reserved;
+		merge_caches(result);
+		for (free_block* f = free_tree; f != nullptr; f = f->right()) result.largest_free = f->size() - header_size;
+		for (size_type c = size_classes; c-- > 0 && result.largest_free == 0;)
+			for (free_block* f = free_blocks[c]; f != nullptr; f = f->next_free) result.largest_free = std::max(result.largest_free, f->size() - header_size);
+		return result;
+	}
+
+	inline bool memory_pool::expand(void* p, size_type n) {
+		block_header* block = header_of(p);
+		if (block == nullptr || n > size_limit()) return false;
+		size_type length = block_length(n);
+		if (length <= block->size()) return true;
+		block_header* next = block->next();
+		if (!next->is_free() || block->size() + next->size() < length) return false;
+		if (!commit(block, reinterpret_cast<pointer>(block) + length + min_block_size)) return false;
+		size_type old = block->size();
+		bool dirty = is_dirty(next);
+		erase_free(next);
+		block->length = old + next->size();
+		block->next()->previous = block->size();
+		if (block->size() - length >= min_block_size) {
+			block_header* tail = split(block, length);
+			insert_free(tail);
+			if (dirty) mark_dirty(tail);
+		}
+		counters.live_bytes += block->size() - old;
+		counters.high_water = std::max(counters.high_water, counters.live_bytes);
+		return true;
+	}
+
+	inline bool memory_pool::shrink(void* p, size_type n) {
+		block_header* block = header_of(p);
+		if (block == nullptr) return false;
+		size_type length = block_length(n);
+		if (length >= block->size()) return length == block->size();
+		size_type old = block->size();
+		block_header* next = block->next();
+		if (next->is_free()) {
+			erase_free(next);
+			block->length = old + next->size();
+			block->next()->previous = block->size();
+		}
+		else if (old - length < min_block_size) return false;
+		block_header* tail = split(block, length);
+		insert_free(tail);
+		mark_dirty(tail);
+		counters.live_bytes -= old - length;
+		++counters.splits;
+		return true;
+	}
+
+	template<typename Pool>
+	typename slab_depot<Pool>::slab* slab_depot<Pool>::slab_of(const void* p) {
+		return reinterpret_cast<slab*>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(slab_size - 1));
+	}
+
+	template<typename Pool>
+	void slab_depot<Pool>::link(slab*& list, slab* s) {
+		s->prev = nullptr;
+		s->next = list;
+		if (s->next != nullptr) s->next->prev = s;
+		list = s;
+	}
+
+	template<typename Pool>
+	void slab_depot<Pool>::unlink(slab*& list, slab* s) {
+		if (s->prev != nullptr) s->prev->next = s->next;
+		else list = s->next;
+		if (s->next != nullptr) s->next->prev = s->prev;
+		s->prev = s->next = nullptr;
+	}
+
+	template<typename Pool>
+	typename slab_depot<Pool>::slab* slab_depot<Pool>::carve(size_type c) {
+		slab* s = idle;
+		if (s != nullptr) {
+			unlink(idle, s);
+			--s->run->idle_slabs;
+		}
+		else {
+			if (fresh_slabs == 0) {
+				fresh = reinterpret_cast<slab*>(pool.allocate(run_size, slab_size));
+				fresh_slabs = run_slabs;
+			}
+			s = reinterpret_cast<slab*>(reinterpret_cast<pointer>(fresh) + (run_slabs - fresh_slabs--) * slab_size);
+			s->run = fresh;
+			s->idle_slabs = 0;
+		}
+		s->free = nullptr;
+		s->used = 0;
+		s->size_class = c;
+		pointer memory = reinterpret_cast<pointer>(s);
+		for (size_type i = capacity(c); i-- > 0;) {
+			free_object* object = reinterpret_cast<free_object*>(memory + header_length + i * object_size(c));
+			object->next = s->free;
+			s->free = object;
+		}
+		link(partial[c], s);
+		return s;
+	}
+
+	template<typename Pool>
+	void slab_depot<Pool>::retire(slab* s) {
+		unlink(partial[s->size_class], s);
+		link(idle, s);
+		slab* run = s->run;
+		if (++run->idle_slabs < run_slabs) return;
+		for (size_type i = 0; i < run_slabs; ++i) unlink(idle, reinterpret_cast<slab*>(reinterpret_cast<pointer>(run) + i * slab_size));
+		pool.deallocate(run, run_size);
+	}
+
+	template<typename Pool>
+	typename slab_depot<Pool>::free_object* slab_depot<Pool>::take(size_type c, size_type count, size_type& taken) {
+		free_object* head = nullptr;
+		taken = 0;
+		while (taken < count) {
+			slab* s = partial[c];
+			if (s == nullptr) {
+				try {
+					s = carve(c);
+				}
+				catch (...) {
+					if (taken == 0) throw;
+					break;
+				}
+			}
+			while (taken < count && s->free != nullptr) {
+				free_object* object = s->free;
+				s->free = object->next;
+				object->next = head;
+				head = object;
+				++s->used;
+				++taken;
+			}
+			if (s->free == nullptr) unlink(partial[c], s);
+		}
+		return head;
+	}
+
+	template<typename Pool>
+	void slab_depot<Pool>::give(void* p) {
+		slab* s = slab_of(p);
+		if (s->free == nullptr) link(partial[s->size_class], s);
+		free_object* object = static_cast<free_object*>(p);
+		object->next = s->free;
+		s->free = object;
+		if (--s->used == 0 && (s->prev != nullptr || s->next != nullptr)) retire(s);
+	}
+
+	template<typename Pool>
+	thread_cache<Pool>::thread_cache() {
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		attach_cache(pool, &counters, 0);
+	}
+
+	template<typename Pool>
+	thread_cache<Pool>::~thread_cache() {
+		for (size_type c = 0; c < cached_classes; ++c) flush(c, counts[c]);
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		detach_cache(pool, &counters, 0);
+		destroyed() = true;
+	}
+
+	template<typename Pool>
+	bool thread_cache<Pool>::is_cached(size_type n) {
+		return thread_cached<Pool>::value && n <= (Pool::granularity << (cached_classes - 1));
+	}
+
+	template<typename Pool>
+	typename thread_cache<Pool>::size_type thread_cache<Pool>::cached_class(size_type n) {
+		size_type c = 0;
+		while ((Pool::granularity << c) < n) ++c;
+		return c;
+	}
+
+	template<typename Pool>
+	bool& thread_cache<Pool>::destroyed() {
+		static thread_local bool flag = false;
+		return flag;
+	}
+
+	template<typename Pool>
+	typename thread_cache<Pool>::pointer thread_cache<Pool>::allocate(size_type n) {
+		size_type c = cached_class(n);
+		if (blocks[c] == nullptr) refill(c);
+		free_object* object = blocks[c];
+		blocks[c] = object->next;
+		--counts[c];
+		counters.count_allocation(n);
+		return reinterpret_cast<pointer>(object);
+	}
+
+	template<typename Pool>
+	void thread_cache<Pool>::deallocate(void* p, size_type n) {
+		size_type c = cached_class(n);
+		counters.count_deallocation(n);
+		free_object* object = static_cast<free_object*>(p);
+		object->next = blocks[c];
+		blocks[c] = object;
+		if (++counts[c] > batch_size * 2) flush(c, batch_size);
+	}
+
+	template<typename Pool>
+	void thread_cache<Pool>::refill(size_type c) {
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		blocks[c] = depot.take(c, batch_size, counts[c]);
+	}
+
+	template<typename Pool>
+	void thread_cache<Pool>::flush(size_type c, size_type count) {
+		if (count == 0) return;
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		for (size_type i = 0; i < count; ++i) {
+			free_object* object = blocks[c];
+			blocks[c] = object->next;
+			depot.give(object);
+		}
+		counts[c] -= count;
+	}
+
+	template<typename T, std::size_t Alignment, typename Pool>
+	void allocator<T, Alignment, Pool>::destroy(pointer p) { p->~value_type(); };
+
+	template<typename T, std::size_t Alignment, typename Pool>
+	bool allocator<T, Alignment, Pool>::is_cached(size_type bytes) const {
+		return _memory == &alloc<Pool>() && alignment <= Pool::granularity && thread_cache<Pool>::is_cached(bytes);
+	}
+
+	template<typename T, std::size_t Alignment, typename Pool>
+	typename allocator<T, Alignment, Pool>::pointer allocator<T, Alignment, Pool>::allocate(size_type n) {
+		if (n > (size_type)(-1) / sizeof(T)) throw std::bad_alloc();
+		size_type bytes = n * sizeof(T);
+		pointer p;
+		if (is_cached(bytes)) p = reinterpret_cast<pointer>(cached_allocate<Pool>(bytes));
+		else {
+			std::lock_guard<typename Pool::mutex_type> lock(_memory->mutex);
+			p = reinterpret_cast<pointer>(_memory->allocate(bytes, alignment));
+		}
+		if (allocation_trace().recording()) allocation_trace().record(trace_event::allocate, p, bytes, alignment);
+		return p;
+	};
+
+	template<typename T, std::size_t Alignment, typename Pool>
+	void allocator<T, Alignment, Pool>::deallocate(pointer p, size_type n) {
+		if (p == nullptr) return;
+		size_type bytes = n * sizeof(T);
+		if (allocation_trace().recording()) allocation_trace().record(trace_event::deallocate, p, bytes, alignment);
+		if (is_cached(bytes)) return cached_deallocate<Pool>(p, bytes);
+		std::unique_lock<typename Pool::mutex_type> lock(_memory->mutex, std::try_to_lock);
+		if (!lock.owns_lock()) {
+			if (_memory->can_defer(p, bytes)) return _memory->defer_deallocate(p, bytes);
+			lock.lock();
+		}
+		_memory->deallocate(p, bytes);
+		if (_memory->remote_frees.load(std::memory_order_relaxed) != nullptr) _memory->drain_remote_frees();
 	};
 
-	template<typename T, typename U>
-	bool operator==(const allocator<T>&, const allocator<U>&) { return true; }
+	template<typename T, std::size_t Alignment, typename Pool>
+	bool allocator<T, Alignment, Pool>::try_expand(pointer p, size_type old_n, size_type new_n) {
+		if (new_n > (size_type)(-1) / sizeof(T)) return false;
+		if (is_cached(old_n * sizeof(T)) || is_cached(new_n * sizeof(T))) return false;
+		std::lock_guard<typename Pool::mutex_type> lock(_memory->mutex);
+		if (!_memory->expand(p, new_n * sizeof(T))) return false;
+		if (allocation_trace().recording()) allocation_trace().record(trace_event::resize, p, new_n * sizeof(T), alignment);
+		return true;
+	};
+
+	template<typename T, std::size_t Alignment, typename Pool>
+	bool allocator<T, Alignment, Pool>::try_shrink(pointer p, size_type old_n, size_type new_n) {
+		if (is_cached(old_n * sizeof(T)) || is_cached(new_n * sizeof(T))) return false;
+		std::lock_guard<typename Pool::mutex_type> lock(_memory->mutex);
+		if (!_memory->shrink(p, new_n * sizeof(T))) return false;
+		if (allocation_trace().recording()) allocation_trace().record(trace_event::resize, p, new_n * sizeof(T), alignment);
+		return true;
+	};
+
+	template<typename A, typename P>
+	auto expand_in_place(A& a, P p, std::size_t old_n, std::size_t new_n, int) -> decltype(a.try_expand(p, old_n, new_n)) {
+		return a.try_expand(p, old_n, new_n);
+	}
+
+	template<typename A, typename P>
+	bool expand_in_place(A&, P, std::size_t, std::size_t, long) { return false; }
+
+	template<typename A, typename P>
+	bool expand_in_place(A& a, P p, std::size_t old_n, std::size_t new_n) {
+		return expand_in_place(a, p, old_n, new_n, 0);
+	}
+
+	template<typename A, typename P>
+	auto shrink_in_place(A& a, P p, std::size_t old_n, std::size_t new_n, int) -> decltype(a.try_shrink(p, old_n, new_n)) {
+		return a.try_shrink(p, old_n, new_n);
+	}
+
+	template<typename A, typename P>
+	bool shrink_in_place(A&, P, std::size_t, std::size_t, long) { return false; }
+
+	template<typename A, typename P>
+	bool shrink_in_place(A& a, P p, std::size_t old_n, std::size_t new_n) {
+		return shrink_in_place(a, p, old_n, new_n, 0);
+	}
+
+	template<typename T, std::size_t A, typename U, std::size_t B, typename P>
+	bool operator==(const allocator<T, A, P>& a, const allocator<U, B, P>& b) { return &a.pool() == &b.pool(); }
+
+	template<typename T, std::size_t A, typename P, typename U, std::size_t B, typename Q>
+	bool operator==(const allocator<T, A, P>&, const allocator<U, B, Q>&) { return false; }
 
-	template<typename T, typename U>
-	bool operator!=(const allocator<T>&, const allocator<U>&) { return false; }
+	template<typename T, std::size_t A, typename P, typename U, std::size_t B, typename Q>
+	bool operator!=(const allocator<T, A, P>& a, const allocator<U, B, Q>& b) { return !(a == b); }
 
 }
\ No newline at end of file
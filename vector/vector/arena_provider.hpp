@@ -0,0 +1,230 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace stl_compatible {
+
+	class arena_provider {
+	public:
+		virtual ~arena_provider() {};
+
+		virtual void* reserve(std::size_t& length) = 0;
+		virtual void* reserve_aligned(std::size_t& length, std::size_t alignment);
+		virtual void release(void* p, std::size_t length) = 0;
+		virtual std::size_t purge(void*, std::size_t) { return 0; };
+		virtual bool commit(void*, std::size_t) { return true; };
+	};
+
+	class heap_arena_provider : public arena_provider {
+	public:
+		void* reserve(std::size_t& length) override;
+		void* reserve_aligned(std::size_t& length, std::size_t alignment) override;
+		void release(void* p, std::size_t length) override;
+	};
+
+	class mapped_arena_provider : public arena_provider {
+	public:
+		static const std::size_t huge_page_size = std::size_t(1) << 21;
+
+		bool use_huge_pages = true;
+		bool explicit_huge_pages = false;
+		bool lazy_purge = false;
+		bool lazy_commit = true;
+
+		void* reserve(std::size_t& length) override;
+		void* reserve_aligned(std::size_t& length, std::size_t alignment) override;
+		void release(void* p, std::size_t length) override;
+		std::size_t purge(void* p, std::size_t length) override;
+		bool commit(void* p, std::size_t length) override;
+
+		static std::size_t page_size();
+		static std::size_t round_up(std::size_t length, std::size_t boundary);
+
+	private:
+		void* map(std::size_t length, bool huge);
+	};
+
+	inline arena_provider& heap_arenas() {
+		static heap_arena_provider provider;
+		return provider;
+	}
+
+	inline arena_provider& mapped_arenas() {
+		static mapped_arena_provider provider;
+		return provider;
+	}
+
+	inline arena_provider& default_arena_provider() {
+		return mapped_arenas();
+	}
+
+	inline void* arena_provider::reserve_aligned(std::size_t& length, std::size_t alignment) {
+		void* p = reserve(length);
+		if (reinterpret_cast<std::uintptr_t>(p) % alignment == 0) return p;
+		release(p, length);
+		throw std::bad_alloc();
+	}
+
+	inline void* heap_arena_provider::reserve(std::size_t& length) {
+		return reserve_aligned(length, alignof(std::max_align_t));
+	}
+
+	inline void* heap_arena_provider::reserve_aligned(std::size_t& length, std::size_t alignment) {
+		alignment = std::max(alignment, sizeof(void*));
+		if (length > std::size_t(-1) - alignment) throw std::bad_alloc();
+		char* raw = static_cast<char*>(::operator new(length + alignment));
+		char* p = raw + alignment - reinterpret_cast<std::uintptr_t>(raw) % alignment;
+		reinterpret_cast<char**>(p)[-1] = raw;
+		return p;
+	}
+
+	inline void heap_arena_provider::release(void* p, std::size_t) {
+		::operator delete(static_cast<char**>(p)[-1]);
+	}
+
+	inline std::size_t mapped_arena_provider::round_up(std::size_t length, std::size_t boundary) {
+		return (length + boundary - 1) / boundary * boundary;
+	}
+
+	inline std::size_t mapped_arena_provider::purge(void* p, std::size_t length) {
+		std::uintptr_t begin = round_up(reinterpret_cast<std::uintptr_t>(p), page_size());
+		std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(p) + length) / page_size() * page_size();
+		if (end <= begin) return 0;
+		void* first = reinterpret_cast<void*>(begin);
+#if defined(_WIN32)
+		if (lazy_purge) return VirtualAlloc(first, end - begin, MEM_RESET, PAGE_READWRITE) != nullptr ? end - begin : 0;
+		if (!VirtualFree(first, end - begin, MEM_DECOMMIT)) return 0;
+		VirtualAlloc(first, end - begin, MEM_COMMIT, PAGE_READWRITE);
+#else
+		int advice = MADV_DONTNEED;
+#if defined(MADV_FREE)
+		if (lazy_purge) advice = MADV_FREE;
+#endif
+		if (madvise(first, end - begin, advice) != 0) return 0;
+#endif
+		return end - begin;
+	}
+
+#if defined(_WIN32)
+	inline std::size_t mapped_arena_provider::page_size() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+	}
+
+	inline void* mapped_arena_provider::map(std::size_t length, bool huge) {
+		DWORD type = MEM_RESERVE | (huge || !lazy_commit ? MEM_COMMIT : 0) | (huge ? MEM_LARGE_PAGES : 0);
+		return VirtualAlloc(nullptr, length, type, PAGE_READWRITE);
+	}
+
+	inline void* mapped_arena_provider::reserve(std::size_t& length) {
+		std::size_t large_page = GetLargePageMinimum();
+		if (use_huge_pages && explicit_huge_pages && large_page != 0 && length >= large_page) {
+			std::size_t huge = round_up(length, large_page);
+			if (void* p = map(huge, true)) {
+				length = huge;
+				return p;
+			}
+		}
+		if (use_huge_pages && length >= huge_page_size) {
+			length = round_up(length, huge_page_size);
+			return reserve_aligned(length, huge_page_size);
+		}
+		length = round_up(length, page_size());
+		void* p = map(length, false);
+		if (p == nullptr) throw std::bad_alloc();
+		return p;
+	}
+
+	inline void mapped_arena_provider::release(void* p, std::size_t) {
+		VirtualFree(p, 0, MEM_RELEASE);
+	}
+
+	inline void* mapped_arena_provider::reserve_aligned(std::size_t& length, std::size_t alignment) {
+		if (alignment <= page_size()) return reserve(length);
+		length = round_up(length, page_size());
+		for (int attempt = 0; attempt < 16; ++attempt) {
+			char* p = static_cast<char*>(VirtualAlloc(nullptr, length + alignment, MEM_RESERVE, PAGE_READWRITE));
+			if (p == nullptr) break;
+			VirtualFree(p, 0, MEM_RELEASE);
+			void* aligned = reinterpret_cast<void*>(round_up(reinterpret_cast<std::uintptr_t>(p), alignment));
+			if (void* q = VirtualAlloc(aligned, length, MEM_RESERVE | (lazy_commit ? 0 : MEM_COMMIT), PAGE_READWRITE)) return q;
+		}
+		throw std::bad_alloc();
+	}
+
+	inline bool mapped_arena_provider::commit(void* p, std::size_t length) {
+		return VirtualAlloc(p, length, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+#else
+	inline std::size_t mapped_arena_provider::page_size() {
+		static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		return size;
+	}
+
+	inline void* mapped_arena_provider::map(std::size_t length, bool huge) {
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+		if (lazy_commit && !huge) flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_HUGETLB)
+		if (huge) flags |= MAP_HUGETLB;
+#else
+		if (huge) return nullptr;
+#endif
+		void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+		return p == MAP_FAILED ? nullptr : p;
+	}
+
+	inline void* mapped_arena_provider::reserve(std::size_t& length) {
+		if (!use_huge_pages || length < huge_page_size) {
+			length = round_up(length, page_size());
+			void* p = map(length, false);
+			if (p == nullptr) throw std::bad_alloc();
+			return p;
+		}
+		std::size_t huge = round_up(length, huge_page_size);
+		if (explicit_huge_pages)
+			if (void* p = map(huge, true)) {
+				length = huge;
+				return p;
+			}
+		length = huge;
+		return reserve_aligned(length, huge_page_size);
+	}
+
+	inline void mapped_arena_provider::release(void* p, std::size_t length) {
+		munmap(p, length);
+	}
+
+	inline void* mapped_arena_provider::reserve_aligned(std::size_t& length, std::size_t alignment) {
+		if (alignment <= page_size()) return reserve(length);
+		length = round_up(length, page_size());
+		char* p = static_cast<char*>(map(length + alignment, false));
+		if (p == nullptr) throw std::bad_alloc();
+		std::size_t head = round_up(reinterpret_cast<std::uintptr_t>(p), alignment) - reinterpret_cast<std::uintptr_t>(p);
+		if (head > 0) munmap(p, head);
+		if (alignment - head > 0) munmap(p + head + length, alignment - head);
+#if defined(MADV_HUGEPAGE)
+		if (use_huge_pages && alignment >= huge_page_size && length >= huge_page_size) madvise(p + head, length, MADV_HUGEPAGE);
+#endif
+		return p + head;
+	}
+
+	inline bool mapped_arena_provider::commit(void*, std::size_t) {
+		return true;
+	}
+#endif
+
+}
\ No newline at end of file
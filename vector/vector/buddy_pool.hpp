@@ -0,0 +1,233 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "allocator.hpp"
+
+namespace stl_compatible {
+
+	struct buddy_pool : remote_free_queue, stats_source {
+
+		typedef char* pointer;
+		typedef std::size_t size_type;
+		typedef std::mutex mutex_type;
+
+		struct free_block {
+
+			free_block* prev;
+			free_block* next;
+		};
+
+		struct buddy_arena {
+
+			pointer begin;
+			size_type length;
+			size_type order;
+			std::vector<unsigned char> tags;
+
+			buddy_arena(pointer begin, size_type length, size_type order)
+				: begin(begin), length(length), order(order), tags((size_type(1) << order) / granularity, 0) {};
+		};
+
+		static const size_type granularity = memory_pool::granularity;
+		static const size_type orders = sizeof(size_type) * 8;
+
+		arena_provider& provider;
+		free_block* free_blocks[orders] = {};
+		std::vector<buddy_arena> arenas;
+		size_type reserved = 0;
+		size_type arena_order = order_of(configured_pool_size());
+		size_type max_size = (size_type(1) << arena_order) * 1024;
+		std::mutex mutex;
+
+		buddy_pool(arena_provider& provider = default_arena_provider()) : provider(provider) {
+			registered_pools().add(this);
+		}
+
+		~buddy_pool() {
+			registered_pools().remove(this);
+			for (auto& arena : arenas) provider.release(arena.begin, arena.length);
+		}
+
+		pointer allocate(size_type n, size_type alignment = granularity);
+		void deallocate(void* p, size_type n);
+		bool expand(void* p, size_type n);
+		bool shrink(void* p, size_type n);
+		void grow(size_type order);
+
+		void drain_remote_frees();
+		double fragmentation() const;
+		pool_stats stats() override;
+		pool_stats snapshot() const override;
+
+		static size_type order_of(size_type n);
+
+	private:
+		buddy_arena* find_arena(void* p);
+		void push_free(buddy_arena& arena, size_type offset, size_type order);
+		void pop_free(buddy_arena& arena, size_type offset, size_type order);
+		unsigned char& tag(buddy_arena& arena, size_type offset);
+	};
+
+	template<typename T>
+	using buddy_allocator = allocator<T, alignof(T), buddy_pool>;
+
+	inline buddy_pool::size_type buddy_pool::order_of(size_type n) {
+		size_type order = 0;
+		while ((size_type(1) << order) < n) ++order;
+		return order;
+	}
+
+	inline buddy_pool::buddy_arena* buddy_pool::find_arena(void* p) {
+		for (auto& arena : arenas)
+			if (static_cast<pointer>(p) >= arena.begin && static_cast<pointer>(p) < arena.begin + (size_type(1) << arena.order)) return &arena;
+		return nullptr;
+	}
+
+	inline unsigned char& buddy_pool::tag(buddy_arena& arena, size_type offset) {
+		return arena.tags[offset / granularity];
+	}
+
+	inline void buddy_pool::push_free(buddy_arena& arena, size_type offset, size_type order) {
+		free_block* block = ::new (arena.begin + offset) free_block{ nullptr, free_blocks[order] };
+		if (block->next != nullptr) block->next->prev = block;
+		free_blocks[order] = block;
+		tag(arena, offset) = static_cast<unsigned char>(order << 1 | 1);
+		++counters.free_blocks;
+	}
+
+	inline void buddy_pool::pop_free(buddy_arena& arena, size_type offset, size_type order) {
+		free_block* block = reinterpret_cast<free_block*>(arena.begin + offset);
+		if (block->prev != nullptr) block->prev->next = block->next;
+		else free_blocks[order] = block->next;
+		if (block->next != nullptr) block->next->prev = block->prev;
+		tag(arena, offset) = 0;
+		--counters.free_blocks;
+	}
+
+	inline void buddy_pool::grow(size_type order) {
+		order = std::max(order, arena_order);
+		size_type length = size_type(1) << order;
+		if (order >= orders - 1 || length > max_size - reserved) throw std::bad_alloc();
+		pointer begin = static_cast<pointer>(provider.reserve_aligned(length, length));
+		if (!provider.commit(begin, length)) {
+			provider.release(begin, length);
+			throw std::bad_alloc();
+		}
+		arenas.emplace_back(begin, length, order);
+		reserved += length;
+		push_free(arenas.back(), 0, order);
+	}
+
+	inline void buddy_pool::drain_remote_frees() {
+		drain(*this);
+	}
+
+	inline buddy_pool::pointer buddy_pool::allocate(size_type n, size_type alignment) {
+		if (n > max_size) throw std::bad_alloc();
+		if (remote_frees.load(std::memory_order_relaxed) != nullptr) drain_remote_frees();
+		size_type order = std::max(order_of(std::max(n, alignment)), order_of(granularity));
+		size_type k = order;
+		while (k < orders && free_blocks[k] == nullptr) ++k;
+		if (k == orders) {
+			grow(order);
+			k = arenas.back().order;
+		}
+		pointer p = reinterpret_cast<pointer>(free_blocks[k]);
+		buddy_arena& arena = *find_arena(p);
+		size_type offset = p - arena.begin;
+		pop_free(arena, offset, k);
+		while (k > order) {
+			--k;
+			push_free(arena, offset + (size_type(1) << k), k);
+			++counters.splits;
+		}
+		tag(arena, offset) = static_cast<unsigned char>(order << 1);
+		count_allocation(size_type(1) << order);
+		return p;
+	}
+
+	inline void buddy_pool::deallocate(void* p, size_type) {
+		buddy_arena* arena = p == nullptr ? nullptr : find_arena(p);
+		if (arena == nullptr) return;
+		size_type offset = static_cast<pointer>(p) - arena->begin;
+		unsigned char block_tag = tag(*arena, offset);
+		if (block_tag == 0 || (block_tag & 1)) return;
+		size_type order = block_tag >> 1;
+		tag(*arena, offset) = 0;
+		count_deallocation(size_type(1) << order);
+		while (order < arena->order) {
+			size_type buddy = offset ^ (size_type(1) << order);
+			if (tag(*arena, buddy) != (order << 1 | 1)) break;
+			pop_free(*arena, buddy, order);
+			offset = std::min(offset, buddy);
+			++order;
+			++counters.coalesces;
+		}
+		push_free(*arena, offset, order);
+	}
+
+	inline double buddy_pool::fragmentation() const {
+		size_type total = reserved - counters.live_bytes, largest = snapshot().largest_free;
+		return total == 0 ? 0.0 : 1.0 - double(largest) / double(total);
+	}
+
+	inline pool_stats buddy_pool::stats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return snapshot();
+	}
+
+	inline pool_stats buddy_pool::snapshot() const {
+		pool_stats result = counters;
+		result.reserved = reserved;
+		merge_caches(result);
+		for (size_type k = orders; k-- > 0;)
+			if (free_blocks[k] != nullptr) {
+				result.largest_free = size_type(1) << k;
+				break;
+			}
+		return result;
+	}
+
+	inline bool buddy_pool::expand(void* p, size_type n) {
+		buddy_arena* arena = find_arena(p);
+		if (arena == nullptr || n > max_size) return false;
+		size_type offset = static_cast<pointer>(p) - arena->begin;
+		if (tag(*arena, offset) == 0 || (tag(*arena, offset) & 1)) return false;
+		size_type order = tag(*arena, offset) >> 1;
+		size_type target = std::max(order_of(n), order_of(granularity));
+		if (target > arena->order) return false;
+		for (size_type k = order; k < target; ++k) {
+			if (offset % (size_type(1) << (k + 1)) != 0) return false;
+			if (tag(*arena, offset + (size_type(1) << k)) != (k << 1 | 1)) return false;
+		}
+		for (size_type k = order; k < target; ++k) pop_free(*arena, offset + (size_type(1) << k), k);
+		if (target > order) {
+			tag(*arena, offset) = static_cast<unsigned char>(target << 1);
+			counters.live_bytes += (size_type(1) << target) - (size_type(1) << order);
+			counters.high_water = std::max(counters.high_water, counters.live_bytes);
+		}
+		return true;
+	}
+
+	inline bool buddy_pool::shrink(void* p, size_type n) {
+		buddy_arena* arena = find_arena(p);
+		if (arena == nullptr) return false;
+		size_type offset = static_cast<pointer>(p) - arena->begin;
+		if (tag(*arena, offset) == 0 || (tag(*arena, offset) & 1)) return false;
+		size_type order = tag(*arena, offset) >> 1;
+		size_type target = std::max(order_of(n), order_of(granularity));
+		if (target > order) return false;
+		while (order > target) {
+			--order;
+			push_free(*arena, offset + (size_type(1) << order), order);
+			counters.live_bytes -= size_type(1) << order;
+			++counters.splits;
+		}
+		tag(*arena, offset) = static_cast<unsigned char>(target << 1);
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include "arena_provider.hpp"
+
+namespace stl_compatible {
+
+	template<std::size_t Numerator, std::size_t Denominator = 1>
+	struct geometric_growth {
+
+		static_assert(Numerator > Denominator && Denominator > 0, "growth factor must be greater than one");
+
+		static std::size_t capacity(std::size_t current, std::size_t required, std::size_t element_size);
+	};
+
+	template<std::size_t Boundary, typename Growth = geometric_growth<2>>
+	struct rounded_growth {
+
+		static std::size_t capacity(std::size_t current, std::size_t required, std::size_t element_size);
+	};
+
+	template<std::size_t Increment>
+	struct fixed_growth {
+
+		static_assert(Increment > 0, "increment must be positive");
+
+		static std::size_t capacity(std::size_t current, std::size_t required, std::size_t element_size);
+	};
+
+	typedef geometric_growth<3, 2> one_and_half_growth;
+	typedef geometric_growth<2> doubling_growth;
+	typedef geometric_growth<1618, 1000> golden_growth;
+	typedef rounded_growth<4096> page_growth;
+	typedef rounded_growth<mapped_arena_provider::huge_page_size> huge_page_growth;
+
+	template<std::size_t Numerator, std::size_t Denominator>
+	std::size_t geometric_growth<Numerator, Denominator>::capacity(std::size_t current, std::size_t required, std::size_t) {
+		if (current > std::size_t(-1) / Numerator) return required;
+		return std::max(required, current * Numerator / Denominator);
+	}
+
+	template<std::size_t Boundary, typename Growth>
+	std::size_t rounded_growth<Boundary, Growth>::capacity(std::size_t current, std::size_t required, std::size_t element_size) {
+		std::size_t grown = Growth::capacity(current, required, element_size);
+		if (grown > (std::size_t(-1) - Boundary) / element_size) return grown;
+		return (grown * element_size + Boundary - 1) / Boundary * Boundary / element_size;
+	}
+
+	template<std::size_t Increment>
+	std::size_t fixed_growth<Increment>::capacity(std::size_t current, std::size_t required, std::size_t) {
+		if (current > std::size_t(-1) - Increment) return required;
+		return std::max(required, current + Increment);
+	}
+
+}
\ No newline at end of file
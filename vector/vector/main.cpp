@@ -4,9 +4,20 @@
 #define PAUSE getchar();getchar()
 #include "allocator.hpp"
 #include "vector.hpp"
+#include "buddy_pool.hpp"
+#include "numa_pool.hpp"
+#include "monotonic_arena.hpp"
+#include "stack_arena.hpp"
+#include "pool_resource.hpp"
 #include "catch.hpp"
+#include <cstring>
 #include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <list>
+#include <sstream>
+#include <string>
+#include <thread>
 #include "benchpress.hpp"
 #include "cxxopts.hpp"
 
@@ -138,6 +149,123 @@ SCENARIO("Vector can reserve items") {
 	}
 }
 
+SCENARIO("Growth policy") {
+
+	WHEN("Capacity is grown by each policy") {
+		THEN("It covers the request and follows the policy") {
+			REQUIRE(stl_compatible::doubling_growth::capacity(100, 101, 4) == 200);
+			REQUIRE(stl_compatible::doubling_growth::capacity(0, 1, 4) == 1);
+			REQUIRE(stl_compatible::one_and_half_growth::capacity(100, 101, 4) == 150);
+			REQUIRE(stl_compatible::golden_growth::capacity(1000, 1001, 4) == 1618);
+			REQUIRE(stl_compatible::doubling_growth::capacity(100, 500, 4) == 500);
+			REQUIRE(stl_compatible::page_growth::capacity(100, 101, 4) == 1024);
+			REQUIRE(stl_compatible::huge_page_growth::capacity(100, 101, 8) == (std::size_t(1) << 18));
+			REQUIRE(stl_compatible::fixed_growth<64>::capacity(100, 101, 4) == 164);
+		}
+	}
+
+	WHEN("Vector grows with a fixed increment") {
+		stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::fixed_growth<64>> v;
+		for (int i = 0; i < 100; ++i) v.push_back(i);
+		THEN("Capacity is a multiple of the increment") {
+			REQUIRE(v.capacity() == 128);
+			REQUIRE(v[99] == 99);
+		}
+	}
+}
+
+SCENARIO("Vector grows in place") {
+
+	WHEN("Block after vector storage is free") {
+		stl_compatible::vector<int> v(100000, 1u);
+		int* storage = v.data();
+		v.reserve(150000);
+		THEN("Storage is extended without moving items") {
+			REQUIRE(v.data() == storage);
+			REQUIRE(v.capacity() >= 150000);
+			REQUIRE(std::count(v.begin(), v.end(), 1) == 100000);
+		}
+	}
+}
+
+SCENARIO("Vector relocates items on growth") {
+
+	WHEN("Vector of vectors grows") {
+		stl_compatible::vector<stl_compatible::vector<int>> v;
+		v.push_back(stl_compatible::vector<int>(100, 7u));
+		int* inner = v[0].data();
+		for (int i = 0; i < 100; ++i) v.push_back(stl_compatible::vector<int>(1, 1u));
+		THEN("Inner vectors are moved, not copied") {
+			REQUIRE(v.size() == 101);
+			REQUIRE(v[0].data() == inner);
+			REQUIRE(v[0][99] == 7);
+		}
+	}
+
+	WHEN("Vector of trivially copyable items grows") {
+		struct point { int x, y; };
+		stl_compatible::vector<point> v;
+		for (int i = 0; i < 1000; ++i) v.push_back(point{ i, -i });
+		THEN("Items are copied bytewise") {
+			REQUIRE(std::is_trivially_copyable<point>::value);
+			REQUIRE(v.size() == 1000);
+			REQUIRE(v[999].x == 999);
+			REQUIRE(v[500].y == -500);
+		}
+	}
+}
+
+struct relocatable {
+	static int moves;
+	int value;
+	relocatable(int value) : value(value) {};
+	relocatable(const relocatable& other) : value(other.value) { ++moves; };
+	relocatable(relocatable&& other) : value(other.value) { ++moves; };
+	relocatable& operator=(const relocatable& other) { value = other.value; ++moves; return *this; };
+};
+
+int relocatable::moves = 0;
+
+namespace stl_compatible {
+	template<>
+	struct is_trivially_relocatable<relocatable> : std::true_type {};
+}
+
+SCENARIO("Relocatable items are moved bytewise") {
+
+	WHEN("Items marked relocatable are reallocated, inserted and erased") {
+		stl_compatible::vector<relocatable> v;
+		for (int i = 0; i < 100; ++i) v.push_back(relocatable(i));
+		relocatable::moves = 0;
+		v.reserve(1000);
+		v.insert(v.begin(), relocatable(-1));
+		v.erase(v.begin() + 10, v.begin() + 20);
+		THEN("Only the inserted item is copied") {
+			REQUIRE(relocatable::moves == 1);
+			REQUIRE(v.size() == 91);
+			REQUIRE(v[0].value == -1);
+			REQUIRE(v[9].value == 8);
+			REQUIRE(v[10].value == 19);
+			REQUIRE(v[90].value == 99);
+		}
+	}
+
+	WHEN("Vectors of vectors are inserted and erased") {
+		stl_compatible::vector<stl_compatible::vector<int>> v;
+		for (int i = 0; i < 10; ++i) v.push_back(stl_compatible::vector<int>(10, unsigned(i)));
+		int* inner = v[5].data();
+		v.insert(v.begin(), 3, stl_compatible::vector<int>(1, 1u));
+		v.erase(v.begin() + 1, v.begin() + 4);
+		THEN("Inner buffers stay in place") {
+			REQUIRE(stl_compatible::is_trivially_relocatable<stl_compatible::vector<int>>::value);
+			REQUIRE(v.size() == 10);
+			REQUIRE(v[0].size() == 1);
+			REQUIRE(v[5].data() == inner);
+			REQUIRE(v[9][9] == 9);
+		}
+	}
+}
+
 SCENARIO("Vector can be modified") {
 
 	WHEN("Assign function passing integer and value") {
@@ -246,6 +374,70 @@ SCENARIO("Vector can be modified") {
 		}
 	}
 
+	WHEN("Insert nothing into vector of strings") {
+		stl_compatible::vector<std::string> v;
+		v.push_back("first");
+		v.push_back("second");
+		std::list<std::string> none;
+		v.insert(v.begin(), 0, std::string("x"));
+		v.insert(v.begin() + 1, none.begin(), none.end());
+		THEN("Items are unaffected") {
+			REQUIRE(v.size() == 2);
+			REQUIRE(v[0] == "first");
+			REQUIRE(v[1] == "second");
+		}
+	}
+
+	WHEN("Push back an item of the full vector itself") {
+		stl_compatible::vector<std::string> v;
+		v.push_back("first");
+		while (v.size() < v.capacity()) v.push_back("more");
+		v.push_back(v[0]);
+		stl_compatible::vector<int> w;
+		w.push_back(42);
+		while (w.size() < w.capacity()) w.push_back(0);
+		w.push_back(w[0]);
+		THEN("The original value is appended") {
+			REQUIRE(v.back() == "first");
+			REQUIRE(w.back() == 42);
+		}
+	}
+
+	WHEN("Emplace an item of the full vector itself") {
+		stl_compatible::vector<std::string> v;
+		v.push_back("first");
+		while (v.size() < v.capacity()) v.push_back("more");
+		v.emplace_back(v[0]);
+		while (v.size() < v.capacity()) v.push_back("more");
+		stl_compatible::vector<std::string>::iterator it = v.begin() + 1;
+		it = v.emplace(it, v[0]);
+		stl_compatible::vector<int> w;
+		w.push_back(42);
+		while (w.size() < w.capacity()) w.push_back(0);
+		w.emplace_back(w[0]);
+		THEN("The original value is constructed in place") {
+			REQUIRE(v.back() == "first");
+			REQUIRE(v[1] == "first");
+			REQUIRE(*it == "first");
+			REQUIRE(w.back() == 42);
+		}
+	}
+
+	WHEN("Insert an item of the vector itself") {
+		stl_compatible::vector<std::string> v;
+		v.push_back("first");
+		v.push_back("second");
+		v.insert(v.begin(), v[0]);
+		v.insert(v.begin() + 1, 2, v[2]);
+		THEN("The original value is inserted") {
+			REQUIRE(v.size() == 5);
+			REQUIRE(v[0] == "first");
+			REQUIRE(v[1] == "second");
+			REQUIRE(v[2] == "second");
+			REQUIRE(v[3] == "first");
+		}
+	}
+
 	WHEN("Erase elements") {
 		stl_compatible::vector<int> v = { 1, 2, 3, 3, 3, 3, 4, 5 };
 		v.erase(v.begin() + 2, v.begin() + 5);
@@ -287,7 +479,9 @@ SCENARIO("Vector can be modified") {
 		v.emplace_back(4, 1u);
 		stl_compatible::vector<int> a = v.front();
 		THEN("Item is created and inserted") {
-			for (stl_compatible::vector<int>::iterator it = a.begin(); it != a.end(); ++it) REQUIRE(*it == 0);
+			REQUIRE(v.size() == 1);
+			REQUIRE(a.size() == 4);
+			for (stl_compatible::vector<int>::iterator it = a.begin(); it != a.end(); ++it) REQUIRE(*it == 1);
 		}
 	}
 
@@ -295,7 +489,9 @@ SCENARIO("Vector can be modified") {
 		stl_compatible::vector<stl_compatible::vector<int>> v(3, stl_compatible::vector<int>(3, 2u));
 		stl_compatible::vector<int> a = *(v.emplace(v.begin() + 1, 3, 1u));
 		THEN("Item is created and inserted at position") {
-			for (stl_compatible::vector<int>::iterator it = a.begin(); it != a.end(); ++it) REQUIRE(*it == 0);
+			REQUIRE(v.size() == 4);
+			REQUIRE(a.size() == 3);
+			for (stl_compatible::vector<int>::iterator it = a.begin(); it != a.end(); ++it) REQUIRE(*it == 1);
 		}
 	}
 }
@@ -394,8 +590,9 @@ SCENARIO("Vector exceptions") {
 
 		class TException : public std::exception {};
 
-		T& operator=(const T&) {
-			throw TException();
+		T() {};
+		T(const T& other) : a(other.a) {
+			if (a == 2) throw TException();
 		}
 
 	};
@@ -416,14 +613,25 @@ SCENARIO("Vector exceptions") {
 
 	WHEN("Exception on copy") {
 		stl_compatible::vector<T> v(1, T());
-		THEN("Exception") {
+		v[0].a = 2;
+		THEN("Exception, items are unaffected") {
 			REQUIRE_THROWS_AS(v.push_back(T()), stl_compatible::exception);
+			REQUIRE(v.size() == 1);
+			REQUIRE(v[0].a == 2);
 		}
 	}
 
 	WHEN("Bad allocation") {
 		THEN("Exception") {
-			REQUIRE_THROWS_AS(stl_compatible::vector<int> v(10000000), std::bad_alloc);
+			REQUIRE_THROWS_AS(stl_compatible::allocator<int>().allocate(stl_compatible::alloc().size_limit() / sizeof(int) + 1), std::bad_alloc);
+		}
+	}
+
+	WHEN("Allocation exceeds initial pool size") {
+		stl_compatible::vector<int> v(10000000);
+		THEN("Pool grows") {
+			REQUIRE(v.size() == 10000000);
+			REQUIRE(stl_compatible::alloc().arenas.size() > 1);
 		}
 	}
 }
@@ -533,6 +741,838 @@ SCENARIO("Allocator can be used by std::vector") {
 	}
 }
 
+SCENARIO("Allocators reference a pool") {
+
+	stl_compatible::memory_pool first, second;
+	stl_compatible::allocator<int> in_first(first), in_second(second);
+
+	WHEN("Allocators are compared") {
+		THEN("They are equal only when they share a pool") {
+			REQUIRE(in_first == stl_compatible::allocator<int>(first));
+			REQUIRE(in_first == stl_compatible::allocator<double>(in_first));
+			REQUIRE(in_first != in_second);
+			REQUIRE(in_first != stl_compatible::allocator<int>());
+		}
+	}
+
+	WHEN("A vector is moved within its pool") {
+		stl_compatible::vector<int> v(in_first), w(in_first);
+		for (int i = 0; i < 1000; ++i) v.push_back(i);
+		int* data = v.data();
+		w = std::move(v);
+		THEN("The buffer is taken over") {
+			REQUIRE(w.data() == data);
+			REQUIRE(w[999] == 999);
+			REQUIRE(first.is_allocated(data));
+		}
+	}
+
+	WHEN("A vector is moved to another pool") {
+		stl_compatible::vector<int> v(in_first), w(in_second);
+		for (int i = 0; i < 1000; ++i) v.push_back(i);
+		w = std::move(v);
+		THEN("Elements are moved into the target pool") {
+			REQUIRE(w.size() == 1000);
+			REQUIRE(w[999] == 999);
+			REQUIRE(w.get_allocator() == in_second);
+			REQUIRE(second.is_allocated(w.data()));
+		}
+	}
+
+	WHEN("Vectors from different pools are swapped or copied") {
+		stl_compatible::vector<int> v(in_first), w(in_second);
+		v.push_back(1);
+		w.push_back(2);
+		w.push_back(3);
+		v.swap(w);
+		stl_compatible::vector<int> copy(v);
+		THEN("Each vector keeps its pool") {
+			REQUIRE(v.size() == 2);
+			REQUIRE(w[0] == 1);
+			REQUIRE(first.owns(v.data()));
+			REQUIRE(second.owns(w.data()));
+			REQUIRE(copy.size() == 2);
+			REQUIRE(copy.get_allocator() == in_first);
+			w = copy;
+			REQUIRE(w[1] == 3);
+			REQUIRE(second.owns(w.data()));
+		}
+	}
+}
+
+SCENARIO("Memory pool") {
+
+	WHEN("Blocks of different size classes are allocated and freed") {
+		stl_compatible::memory_pool pool;
+		char* blocks[6];
+		std::size_t sizes[6] = { 1, 7, 8, 100, 3, 1000 };
+		for (int i = 0; i < 6; ++i) blocks[i] = pool.allocate(sizes[i]);
+		pool.deallocate(blocks[1], sizes[1]);
+		pool.deallocate(blocks[4], sizes[4]);
+		char* reused = pool.allocate(5);
+		THEN("Most recently freed block is reused and blocks do not overlap") {
+			REQUIRE(reused == blocks[4]);
+			for (int i = 0; i < 6; ++i)
+				for (int j = i + 1; j < 6; ++j)
+					if (i != 1 && i != 4 && j != 1 && j != 4) REQUIRE((blocks[i] + sizes[i] <= blocks[j] || blocks[j] + sizes[j] <= blocks[i]));
+		}
+		pool.deallocate(reused, 5);
+		for (int i = 0; i < 6; ++i) if (i != 1 && i != 4) pool.deallocate(blocks[i], sizes[i]);
+		THEN("All blocks are coalesced back") {
+			REQUIRE(pool.block_count() == 1);
+			REQUIRE(pool.stats().largest_free == pool.default_size - 2 * pool.header_size);
+		}
+	}
+
+	WHEN("Block between two free blocks is freed") {
+		stl_compatible::memory_pool pool;
+		char* first = pool.allocate(10);
+		char* second = pool.allocate(10);
+		char* third = pool.allocate(10);
+		pool.deallocate(first, 10);
+		pool.deallocate(third, 10);
+		pool.deallocate(first + 1, 9);
+		REQUIRE(pool.block_count() == 3);
+		REQUIRE(pool.is_allocated(second));
+		pool.deallocate(second, 10);
+		THEN("Both neighbours are coalesced") {
+			REQUIRE(pool.block_count() == 1);
+			REQUIRE_FALSE(pool.is_allocated(second));
+		}
+	}
+
+	WHEN("Pool is exhausted") {
+		stl_compatible::memory_pool pool;
+		std::size_t capacity = pool.default_size - 2 * pool.header_size;
+		char* whole = pool.allocate(capacity);
+		char* extra = pool.allocate(1);
+		THEN("New arena of geometrically bigger size is added") {
+			REQUIRE(pool.arenas.size() == 2);
+			REQUIRE(pool.arenas.back().length == pool.default_size * pool.growth_factor);
+			REQUIRE(extra == pool.arenas.back().begin + pool.header_size);
+		}
+		pool.deallocate(whole, capacity);
+		pool.deallocate(extra, 1);
+		THEN("Blocks of different arenas are not coalesced") {
+			REQUIRE(pool.block_count() == pool.arenas.size());
+		}
+	}
+
+	WHEN("Block is expanded and shrunk in place") {
+		stl_compatible::memory_pool pool;
+		char* first = pool.allocate(100);
+		char* second = pool.allocate(100);
+		REQUIRE_FALSE(pool.expand(first, 200));
+		pool.deallocate(second, 100);
+		THEN("Free right neighbour is taken and given back") {
+			REQUIRE(pool.expand(first, 200));
+			REQUIRE(pool.usable_size(first) == pool.round_up(200));
+			REQUIRE(pool.shrink(first, 50));
+			REQUIRE(pool.usable_size(first) == pool.round_up(50));
+			REQUIRE(pool.block_count() == 2);
+		}
+		pool.deallocate(first, 50);
+	}
+
+	WHEN("Pools with different fit policies serve the same requests") {
+		stl_compatible::memory_pool classes(stl_compatible::default_arena_provider(), stl_compatible::fit_policy::size_classes);
+		stl_compatible::memory_pool best(stl_compatible::default_arena_provider(), stl_compatible::fit_policy::best_fit);
+		char* picked[2];
+		stl_compatible::memory_pool* pools[2] = { &classes, &best };
+		for (int i = 0; i < 2; ++i) {
+			stl_compatible::memory_pool& pool = *pools[i];
+			char* big = pool.allocate(224);
+			pool.allocate(16);
+			char* small = pool.allocate(144);
+			pool.allocate(16);
+			pool.deallocate(small, 144);
+			pool.deallocate(big, 224);
+			picked[i] = pool.allocate(128);
+			char* next = pool.allocate(208);
+			REQUIRE(picked[i] == (i == 0 ? big : small));
+			REQUIRE((next == big) == (i == 1));
+		}
+		THEN("Best fit leaves less fragmented free space") {
+			REQUIRE(best.fragmentation() < classes.fragmentation());
+		}
+	}
+
+	WHEN("Best fit chooses among many equal free blocks") {
+		stl_compatible::memory_pool pool(stl_compatible::default_arena_provider(), stl_compatible::fit_policy::best_fit);
+		std::vector<char*> blocks;
+		for (int i = 0; i < 1000; ++i) blocks.push_back(pool.allocate(i % 2 == 0 ? 96 : 16));
+		for (int i = 999; i >= 0; i -= 2) pool.deallocate(blocks[i - 1], 96);
+		THEN("The lowest addressed block of the smallest fitting size is used") {
+			REQUIRE(pool.allocate(80) == blocks[0]);
+			REQUIRE(pool.allocate(96) == blocks[2]);
+			REQUIRE(pool.stats().free_blocks == 499);
+		}
+	}
+
+	WHEN("Size class holds many blocks that are slightly too small") {
+		stl_compatible::memory_pool pool;
+		std::vector<char*> blocks;
+		for (int i = 0; i < 1000; ++i) blocks.push_back(pool.allocate(i % 2 == 0 ? 784 : 16));
+		for (int i = 0; i < 1000; i += 2) pool.deallocate(blocks[i], 784);
+		char* p = pool.allocate(900);
+		THEN("A block of a larger class is taken without growing the pool") {
+			REQUIRE(p > blocks.back());
+			REQUIRE(pool.arenas.size() == 1);
+			REQUIRE(pool.stats().free_blocks == 501);
+		}
+	}
+
+	WHEN("Pool statistics are queried") {
+		std::ostringstream out;
+		stl_compatible::memory_pool pool;
+		pool.dump_stream = &out;
+		pool.dump_interval = 2;
+		char* first = pool.allocate(100);
+		char* second = pool.allocate(1000);
+		pool.deallocate(first, 100);
+		stl_compatible::pool_stats stats = pool.stats();
+		THEN("Counters reflect pool activity") {
+			REQUIRE(stats.live_bytes == 1008);
+			REQUIRE(stats.high_water == 1120);
+			REQUIRE(stats.allocations == 2);
+			REQUIRE(stats.deallocations == 1);
+			REQUIRE(stats.splits == 2);
+			REQUIRE(stats.free_blocks == 2);
+			REQUIRE(stats.largest_free == pool.default_size - 1120 - 4 * pool.header_size);
+			REQUIRE(stats.reserved == pool.default_size);
+			REQUIRE(out.str().find("allocations 2") != std::string::npos);
+		}
+		THEN("Pool is part of the aggregated statistics") {
+			stl_compatible::pool_stats total = stl_compatible::total_stats();
+			REQUIRE(total.reserved >= pool.default_size + stl_compatible::alloc().reserved);
+			REQUIRE(total.allocations >= stats.allocations);
+		}
+		pool.deallocate(second, 1000);
+	}
+
+	WHEN("Small blocks go through the thread cache") {
+		stl_compatible::allocator<int> a;
+		stl_compatible::pool_stats before = stl_compatible::alloc().stats();
+		int* p = a.allocate(10);
+		stl_compatible::pool_stats during = stl_compatible::alloc().stats();
+		a.deallocate(p, 10);
+		std::thread([]() {
+			stl_compatible::allocator<int> b;
+			b.deallocate(b.allocate(10), 10);
+		}).join();
+		stl_compatible::pool_stats after = stl_compatible::alloc().stats();
+		THEN("Cache hits are counted, including those of finished threads") {
+			REQUIRE(during.cached_allocations == before.cached_allocations + 1);
+			REQUIRE(during.cached_bytes == before.cached_bytes + 10 * sizeof(int));
+			REQUIRE(after.cached_allocations == before.cached_allocations + 2);
+			REQUIRE(after.cached_deallocations == before.cached_deallocations + 2);
+			REQUIRE(after.cached_bytes == before.cached_bytes);
+		}
+	}
+
+	WHEN("Provider rounds an arena past the size limit") {
+		stl_compatible::memory_pool pool;
+		pool.default_size = 100;
+		pool.max_size = 100;
+		std::vector<char*> blocks;
+		bool exhausted = false;
+		try {
+			for (int i = 0; i < 1000; ++i) blocks.push_back(pool.allocate(64));
+		}
+		catch (const std::bad_alloc&) {
+			exhausted = true;
+		}
+		THEN("Pool stops growing") {
+			REQUIRE(exhausted);
+			REQUIRE(pool.arenas.size() == 1);
+		}
+		for (char* block : blocks) pool.deallocate(block, 64);
+	}
+
+	WHEN("Default size changes after the pool is created") {
+		stl_compatible::memory_pool pool;
+		pool.default_size = std::size_t(1) << 12;
+		THEN("Size limit follows it") {
+			REQUIRE(pool.size_limit() == (std::size_t(1) << 22));
+			REQUIRE_THROWS_AS(pool.allocate((std::size_t(1) << 22) + 1), std::bad_alloc);
+		}
+	}
+
+	WHEN("Pool is created") {
+		stl_compatible::memory_pool pool;
+		THEN("No memory is reserved until the first allocation") {
+			REQUIRE(pool.arenas.empty());
+			REQUIRE(pool.stats().reserved == 0);
+		}
+		const std::size_t step = stl_compatible::memory_pool::commit_granularity;
+		pool.default_size = std::size_t(1) << 20;
+		char* block = pool.allocate(100);
+		THEN("First arena uses the configured size and is committed incrementally") {
+			REQUIRE(pool.arenas.front().length == std::size_t(1) << 20);
+			REQUIRE(pool.arenas.front().committed == step);
+			REQUIRE(pool.expand(block, 100000));
+			REQUIRE(pool.arenas.front().committed == 2 * step);
+		}
+		pool.deallocate(block, 100000);
+	}
+
+	WHEN("Pool is backed by heap arenas") {
+		stl_compatible::memory_pool pool(stl_compatible::heap_arenas());
+		char* block = pool.allocate(100);
+		THEN("Arena has the requested size") {
+			REQUIRE(pool.arenas.front().length == pool.default_size);
+			REQUIRE(pool.is_allocated(block));
+		}
+		pool.deallocate(block, 100);
+	}
+
+	WHEN("Free pages are trimmed") {
+		const std::size_t page = stl_compatible::mapped_arena_provider::page_size(), mib = std::size_t(1) << 20;
+		stl_compatible::memory_pool pool;
+		char* first = pool.allocate(mib);
+		char* second = pool.allocate(4 * mib);
+		char* third = pool.allocate(mib);
+		std::memset(first, 1, mib);
+		std::memset(second, 2, 4 * mib);
+		std::memset(third, 3, mib);
+		pool.deallocate(second, 4 * mib);
+		std::size_t released = pool.trim();
+		THEN("Interior pages of free blocks are released and live blocks are kept") {
+			REQUIRE(released >= 4 * mib - 2 * page);
+			REQUIRE(first[mib - 1] == 1);
+			REQUIRE(third[0] == 3);
+			REQUIRE(pool.stats().trimmed == released);
+		}
+		THEN("Pages already released are not counted again") {
+			REQUIRE(released < 5 * mib);
+			REQUIRE(pool.trim() == 0);
+			REQUIRE(pool.stats().trimmed == released);
+		}
+		pool.trim_threshold = mib;
+		pool.deallocate(first, mib);
+		THEN("Pool trims itself once enough memory is freed") {
+			REQUIRE(pool.stats().trimmed > released);
+		}
+		pool.deallocate(third, mib);
+	}
+
+	WHEN("Arena is mapped") {
+		stl_compatible::mapped_arena_provider provider;
+		std::size_t small = 100, large = stl_compatible::mapped_arena_provider::huge_page_size * 3 + 1;
+		char* first = static_cast<char*>(provider.reserve(small));
+		char* second = static_cast<char*>(provider.reserve(large));
+		first[small - 1] = second[large - 1] = 1;
+		THEN("Arena is rounded to whole pages and huge pages are aligned") {
+			REQUIRE(small == stl_compatible::mapped_arena_provider::page_size());
+			REQUIRE(large == stl_compatible::mapped_arena_provider::huge_page_size * 4);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(second) % stl_compatible::mapped_arena_provider::huge_page_size == 0);
+		}
+		THEN("Huge page arenas can still be purged page by page") {
+			REQUIRE_FALSE(provider.explicit_huge_pages);
+			REQUIRE(provider.purge(second + provider.page_size(), provider.page_size()) == provider.page_size());
+		}
+		provider.release(first, small);
+		provider.release(second, large);
+	}
+
+	WHEN("Block freed by one element type is requested by another") {
+		stl_compatible::allocator<int> ints;
+		stl_compatible::allocator<double> doubles;
+		int* block = ints.allocate(20000);
+		ints.deallocate(block, 20000);
+		double* other = doubles.allocate(10000);
+		THEN("Both types share the same arena") {
+			REQUIRE(static_cast<void*>(block) == static_cast<void*>(other));
+		}
+		doubles.deallocate(other, 10000);
+	}
+}
+
+SCENARIO("Buddy pool") {
+
+	WHEN("Blocks are allocated and freed") {
+		stl_compatible::buddy_pool pool;
+		char* first = pool.allocate(100);
+		char* second = pool.allocate(100);
+		char* third = pool.allocate(1000);
+		THEN("Blocks are power of two sized buddies") {
+			REQUIRE(second - first == 128);
+			REQUIRE((third - pool.arenas.front().begin) % 1024 == 0);
+		}
+		pool.deallocate(second, 100);
+		THEN("Block grows into its free buddy and shrinks back") {
+			REQUIRE(pool.expand(first, 256));
+			REQUIRE(pool.expand(first, 1024));
+			REQUIRE_FALSE(pool.expand(first, 2048));
+			REQUIRE(pool.shrink(first, 16));
+		}
+		pool.deallocate(first, 100);
+		pool.deallocate(third, 1000);
+		THEN("Buddies are merged back into the whole arena") {
+			REQUIRE(reinterpret_cast<char*>(pool.free_blocks[pool.arena_order]) == pool.arenas.front().begin);
+		}
+	}
+
+	WHEN("Blocks need more alignment than the arena provider gives") {
+		stl_compatible::buddy_pool heap(stl_compatible::heap_arenas()), small;
+		small.arena_order = stl_compatible::buddy_pool::order_of(std::size_t(1) << 20);
+		char* page = heap.allocate(100, 4096);
+		char* slab = small.allocate(1 << 16, 1 << 16);
+		char* huge = small.allocate(100, std::size_t(1) << 22);
+		THEN("Arenas are aligned to their size and blocks to theirs") {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(heap.arenas.front().begin) % (std::size_t(1) << heap.arena_order) == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(page) % 4096 == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(slab) % (1 << 16) == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(huge) % (std::size_t(1) << 22) == 0);
+		}
+		heap.deallocate(page, 100);
+		small.deallocate(slab, 1 << 16);
+		small.deallocate(huge, 100);
+	}
+
+	WHEN("Vector uses buddy allocator") {
+		stl_compatible::vector<int, stl_compatible::buddy_allocator<int>> v;
+		for (int i = 0; i < 100000; ++i) v.push_back(i);
+		THEN("Vector contains all items") {
+			REQUIRE(v.size() == 100000);
+			REQUIRE(v[99999] == 99999);
+		}
+	}
+}
+
+SCENARIO("NUMA pool") {
+
+	WHEN("Pool is created for every node") {
+		stl_compatible::numa_pool pool;
+		char* block = pool.allocate(100000);
+		THEN("Block comes from the pool of the calling thread's node") {
+			REQUIRE_FALSE(stl_compatible::thread_cache<stl_compatible::numa_pool>::is_cached(16));
+			REQUIRE(pool.nodes.size() == stl_compatible::numa_pool::numa_nodes());
+			REQUIRE(pool.owner(block) == &pool.local_pool());
+			REQUIRE(pool.expand(block, 200000));
+		}
+		pool.deallocate(block, 200000);
+		THEN("Block is returned to its node") {
+			REQUIRE(pool.local_pool().stats().live_bytes == 0);
+		}
+	}
+
+	WHEN("Node does not exist") {
+		stl_compatible::node_arena_provider provider(1000);
+		std::size_t length = 100;
+		char* arena = static_cast<char*>(provider.reserve(length));
+		arena[0] = 1;
+		THEN("Arena is still reserved") {
+			REQUIRE(length == stl_compatible::mapped_arena_provider::page_size());
+		}
+		provider.release(arena, length);
+	}
+
+	WHEN("Vectors are built on several threads") {
+		std::vector<std::thread> threads;
+		bool results[4] = {};
+		for (int t = 0; t < 4; ++t)
+			threads.emplace_back([&results, t]() {
+				stl_compatible::vector<int, stl_compatible::numa_allocator<int>> v;
+				for (int i = 0; i < 100000; ++i) v.push_back(i);
+				results[t] = v.size() == 100000 && v[99999] == 99999;
+			});
+		for (auto& thread : threads) thread.join();
+		THEN("Every thread gets its own vector") {
+			REQUIRE(results[0]);
+			REQUIRE(results[1]);
+			REQUIRE(results[2]);
+			REQUIRE(results[3]);
+		}
+	}
+
+	WHEN("Statistics are read while a node pool is in use") {
+		std::atomic<bool> done{ false };
+		std::thread reader([&done]() {
+			while (!done) stl_compatible::total_stats();
+		});
+		stl_compatible::vector<int, stl_compatible::numa_allocator<int>> v;
+		for (int i = 0; i < 100000; ++i) v.push_back(i);
+		done = true;
+		reader.join();
+		THEN("Node pools are locked while they change") {
+			REQUIRE(v[99999] == 99999);
+		}
+	}
+}
+
+SCENARIO("Monotonic arena") {
+
+	WHEN("Vectors are built inside a scope") {
+		stl_compatible::monotonic_arena arena;
+		int* first = nullptr;
+		{
+			stl_compatible::monotonic_scope scope(arena);
+			first = stl_compatible::monotonic_allocator<int>().allocate(1);
+			stl_compatible::vector<int, stl_compatible::monotonic_allocator<int>> v, w;
+			for (int i = 0; i < 100000; ++i) v.push_back(i);
+			w.push_back(1);
+			THEN("Storage is bumped out of the arena") {
+				REQUIRE(v[99999] == 99999);
+				REQUIRE(w[0] == 1);
+				REQUIRE(arena.used() >= 100001 * sizeof(int));
+				REQUIRE(v.get_allocator() == w.get_allocator());
+			}
+		}
+		THEN("Arena is reset at scope exit and its chunks are reused") {
+			REQUIRE(arena.used() == 0);
+			stl_compatible::monotonic_allocator<int> ints(arena);
+			REQUIRE(ints.allocate(1) == first);
+		}
+	}
+
+	WHEN("Last block is expanded") {
+		stl_compatible::monotonic_arena arena;
+		char* first = arena.allocate(100);
+		char* second = arena.allocate(100);
+		THEN("Only the block at the bump pointer grows in place") {
+			REQUIRE_FALSE(arena.expand(first, 100, 200));
+			REQUIRE(arena.expand(second, 100, 200));
+			REQUIRE(arena.allocate(1) >= second + 200);
+		}
+	}
+
+	WHEN("No scope is active") {
+		stl_compatible::monotonic_allocator<int> ints;
+		THEN("Allocation fails") {
+			REQUIRE_THROWS_AS(ints.allocate(1), std::bad_alloc);
+		}
+	}
+}
+
+SCENARIO("Stack arena") {
+
+	typedef stl_compatible::stack_allocator<int, 4096> stack_ints;
+
+	WHEN("Vector fits into the buffer") {
+		stl_compatible::arena<4096> buffer;
+		stl_compatible::vector<int, stack_ints> v{ stack_ints(buffer) };
+		for (int i = 0; i < 500; ++i) v.push_back(i);
+		THEN("Storage lives in the buffer and grows in place") {
+			REQUIRE(buffer.owns(v.data()));
+			REQUIRE(v[499] == 499);
+			REQUIRE(buffer.used() == v.capacity() * sizeof(int));
+		}
+	}
+
+	WHEN("Vector outgrows the buffer") {
+		stl_compatible::arena<4096> buffer;
+		stl_compatible::vector<int, stack_ints> v{ stack_ints(buffer) };
+		for (int i = 0; i < 2000; ++i) v.push_back(i);
+		THEN("Storage overflows to the pool") {
+			REQUIRE_FALSE(buffer.owns(v.data()));
+			REQUIRE(v[1999] == 1999);
+		}
+	}
+
+	WHEN("Last block in the buffer is freed") {
+		stl_compatible::arena<4096> buffer;
+		stack_ints ints(buffer);
+		stl_compatible::stack_allocator<double, 4096> doubles(ints);
+		int* first = ints.allocate(10);
+		double* second = doubles.allocate(10);
+		doubles.deallocate(second, 10);
+		THEN("Its space is handed out again") {
+			REQUIRE(doubles.allocate(10) == second);
+			REQUIRE(reinterpret_cast<char*>(second) >= reinterpret_cast<char*>(first + 10));
+			REQUIRE(ints == doubles);
+		}
+	}
+
+	WHEN("Full buffer hands out an empty block") {
+		stl_compatible::arena<4096> buffer;
+		stack_ints ints(buffer);
+		int* first = ints.allocate(1024);
+		int* empty = ints.allocate(0);
+		ints.deallocate(empty, 0);
+		stl_compatible::allocator<int> pool;
+		int* next = pool.allocate(1);
+		THEN("Empty block is not given to the pool") {
+			REQUIRE((next < first || next > first + 1024));
+			REQUIRE(buffer.owns(empty));
+			pool.deallocate(next, 1);
+			ints.deallocate(first, 1024);
+		}
+	}
+}
+
+SCENARIO("Pool memory resource") {
+
+	WHEN("Standard and pool vectors share one resource") {
+		stl_compatible::memory_pool pool;
+		stl_compatible::pool_resource<> resource(pool);
+		stl_compatible::pmr::vector<int> v{ &resource };
+		std::pmr::vector<int> w{ &resource };
+		for (int i = 0; i < 10000; ++i) {
+			v.push_back(i);
+			w.push_back(i);
+		}
+		THEN("Both vectors draw from the pool") {
+			REQUIRE(v[9999] == 9999);
+			REQUIRE(w[9999] == 9999);
+			REQUIRE(pool.is_allocated(v.data()));
+			REQUIRE(pool.is_allocated(w.data()));
+			REQUIRE(v.get_allocator() == w.get_allocator());
+		}
+	}
+
+	WHEN("Resources wrap the same pool") {
+		stl_compatible::memory_pool pool;
+		stl_compatible::pool_resource<> first(pool), second(pool), other;
+		THEN("They compare equal") {
+			REQUIRE(first == second);
+			REQUIRE(first != other);
+			REQUIRE(*stl_compatible::pool_memory_resource() == other);
+		}
+	}
+
+	WHEN("Vectors backed by the shared resource are swapped") {
+		stl_compatible::pmr::vector<int> v{ stl_compatible::pool_memory_resource() }, w{ stl_compatible::pool_memory_resource() };
+		v.push_back(1);
+		w.push_back(2);
+		w.push_back(3);
+		v.swap(w);
+		THEN("Contents are exchanged") {
+			REQUIRE(v.size() == 2);
+			REQUIRE(w[0] == 1);
+		}
+	}
+}
+
+SCENARIO("Allocation trace") {
+
+	WHEN("Allocator calls are recorded and replayed") {
+		std::stringstream trace;
+		stl_compatible::allocation_trace().start(trace);
+		{
+			stl_compatible::vector<int> v;
+			for (int i = 0; i < 100000; ++i) v.push_back(i);
+		}
+		stl_compatible::allocation_trace().stop();
+		std::vector<stl_compatible::trace_record> records = stl_compatible::read_trace(trace);
+		std::size_t allocations = 0, deallocations = 0;
+		for (auto& record : records) {
+			if (record.event == stl_compatible::trace_event::allocate) ++allocations;
+			if (record.event == stl_compatible::trace_event::deallocate) ++deallocations;
+		}
+		stl_compatible::memory_pool pool;
+		stl_compatible::buddy_pool buddy;
+		stl_compatible::replay(records, pool);
+		stl_compatible::replay(records, buddy);
+		THEN("Every call is in the trace") {
+			REQUIRE(allocations > 0);
+			REQUIRE(allocations == deallocations);
+			REQUIRE(records.front().size == sizeof(int));
+			REQUIRE(records.front().thread == stl_compatible::allocation_recorder::thread_index());
+			REQUIRE(records.back().time >= records.front().time);
+		}
+		THEN("Replay leaves no live blocks behind") {
+			REQUIRE(pool.stats().allocations == allocations);
+			REQUIRE(pool.stats().live_bytes == 0);
+			REQUIRE(buddy.stats().live_bytes == 0);
+		}
+	}
+
+	WHEN("Trace peaks with holes between live blocks") {
+		std::vector<stl_compatible::trace_record> records;
+		for (std::uint64_t i = 1; i <= 10; ++i) records.push_back({ 0, i, 1024, 0, 16, stl_compatible::trace_event::allocate, 0 });
+		for (std::uint64_t i = 1; i <= 10; i += 2) records.push_back({ 0, i, 1024, 0, 16, stl_compatible::trace_event::deallocate, 0 });
+		records.push_back({ 0, 11, 8192, 0, 16, stl_compatible::trace_event::allocate, 0 });
+		stl_compatible::memory_pool pool;
+		stl_compatible::replay_result result = stl_compatible::replay(records, pool);
+		THEN("Fragmentation is sampled before the remaining blocks are freed") {
+			REQUIRE(result.fragmentation > 0.0);
+			REQUIRE(pool.stats().live_bytes == 0);
+		}
+	}
+
+	WHEN("Stream is not a trace") {
+		std::stringstream garbage("garbage");
+		THEN("Reading fails") {
+			REQUIRE_THROWS_AS(stl_compatible::read_trace(garbage), std::runtime_error);
+		}
+	}
+}
+
+SCENARIO("Aligned allocation") {
+
+	struct alignas(128) line { char data[128]; };
+
+	WHEN("Allocator is given an alignment") {
+		stl_compatible::allocator<double, 32> avx;
+		stl_compatible::cache_aligned_allocator<char> cache_line;
+		double* first = avx.allocate(3);
+		char* second = cache_line.allocate(1);
+		double* third = avx.allocate(100000);
+		THEN("Storage starts on the requested boundary") {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(first) % 32 == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(second) % stl_compatible::cache_line_size == 0);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(third) % 32 == 0);
+		}
+		avx.deallocate(first, 3);
+		cache_line.deallocate(second, 1);
+		avx.deallocate(third, 100000);
+	}
+
+	WHEN("Element type is over-aligned") {
+		stl_compatible::vector<line> v(5);
+		THEN("Vector storage honors alignof(T)") {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(v.data()) % alignof(line) == 0);
+		}
+	}
+
+	WHEN("Aligned allocator is rebound by std::vector") {
+		std::vector<int, stl_compatible::allocator<int, 64>> v = { 1, 2, 3, 4, 5 };
+		THEN("Storage is aligned") {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(v.data()) % 64 == 0);
+		}
+	}
+}
+
+SCENARIO("Thread cache") {
+
+	WHEN("Small block is freed and requested again") {
+		stl_compatible::allocator<int> a;
+		int* first = a.allocate(3);
+		a.deallocate(first, 3);
+		int* second = a.allocate(4);
+		THEN("Block is served from the cache of the thread") {
+			REQUIRE(first == second);
+		}
+		a.deallocate(second, 4);
+	}
+
+	WHEN("Single elements are allocated") {
+		typedef stl_compatible::slab_depot<stl_compatible::memory_pool> depot;
+		std::list<int, stl_compatible::allocator<int>> nodes;
+		for (int i = 0; i < 1000; ++i) nodes.push_back(i);
+		stl_compatible::allocator<int> a;
+		int* first = a.allocate(1);
+		int* second = a.allocate(1);
+		THEN("They are carved out of slabs of their size class") {
+			REQUIRE(first != second);
+			REQUIRE(depot::slab_of(first)->size_class == 0);
+			REQUIRE(depot::slab_of(&nodes.back())->size_class == depot::slab_of(&nodes.front())->size_class);
+			REQUIRE(nodes.back() == 999);
+		}
+		a.deallocate(first, 1);
+		a.deallocate(second, 1);
+	}
+
+	WHEN("Slab objects are taken and given back") {
+		typedef stl_compatible::slab_depot<stl_compatible::memory_pool> depot;
+		stl_compatible::memory_pool pool;
+		depot slabs(pool);
+		std::size_t taken = 0, count = depot::capacity(2) + 1;
+		depot::free_object* objects = slabs.take(2, count, taken);
+		THEN("Objects fill a slab before the next one is carved from the same run") {
+			REQUIRE(taken == count);
+			REQUIRE(pool.stats().allocations == 1);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(depot::slab_of(objects)) % depot::slab_size == 0);
+			REQUIRE(depot::slab_of(objects)->run == slabs.fresh);
+		}
+		while (objects != nullptr) {
+			depot::free_object* next = objects->next;
+			slabs.give(objects);
+			objects = next;
+		}
+		THEN("Empty slabs are kept for reuse except the last one") {
+			REQUIRE(pool.stats().deallocations == 0);
+			REQUIRE(slabs.idle != nullptr);
+			REQUIRE(slabs.fresh->idle_slabs == 1);
+			REQUIRE(slabs.partial[2] != nullptr);
+			REQUIRE(slabs.partial[2]->used == 0);
+		}
+	}
+
+	WHEN("Slabs fill a whole run") {
+		typedef stl_compatible::slab_depot<stl_compatible::memory_pool> depot;
+		stl_compatible::memory_pool pool;
+		depot slabs(pool);
+		std::size_t taken = 0, per_run = depot::capacity(0) * depot::run_slabs;
+		std::vector<depot::free_object*> objects;
+		for (depot::free_object* object = slabs.take(0, per_run + 1, taken); object != nullptr; object = object->next) objects.push_back(object);
+		std::size_t reserved = pool.stats().reserved;
+		depot::slab* first = depot::slab_of(objects.back());
+		depot::slab* last = depot::slab_of(objects[1]);
+		THEN("Slabs of a run are adjacent") {
+			REQUIRE(reinterpret_cast<char*>(last) - reinterpret_cast<char*>(first) == (depot::run_slabs - 1) * depot::slab_size);
+			REQUIRE(pool.stats().allocations == 2);
+			REQUIRE(pool.stats().live_bytes <= 2 * depot::run_size + 2 * depot::slab_size);
+		}
+		for (std::size_t i = 1; i < objects.size(); ++i) slabs.give(objects[i]);
+		THEN("Run is returned to the pool once all of its slabs are empty") {
+			REQUIRE(pool.stats().deallocations == 1);
+			REQUIRE(pool.stats().reserved == reserved);
+			REQUIRE(slabs.idle == nullptr);
+			REQUIRE(slabs.partial[0] == depot::slab_of(objects[0]));
+		}
+		slabs.give(objects[0]);
+	}
+
+	WHEN("Vectors are built on several threads") {
+		std::vector<std::thread> threads;
+		bool results[4] = {};
+		for (std::size_t t = 0; t < 4; ++t) {
+			threads.emplace_back([&results, t]() {
+				bool valid = true;
+				for (int k = 0; k < 100; ++k) {
+					stl_compatible::vector<int> v;
+					for (int i = 0; i < 1000; ++i) v.push_back(i);
+					for (int i = 0; i < 1000; ++i) valid = valid && v[i] == i;
+				}
+				results[t] = valid;
+			});
+		}
+		for (auto& thread : threads) thread.join();
+		THEN("Every thread sees its own data") {
+			for (std::size_t t = 0; t < 4; ++t) REQUIRE(results[t]);
+		}
+	}
+
+	WHEN("Big block is freed by another thread while the pool is busy") {
+		stl_compatible::allocator<int> a;
+		stl_compatible::memory_pool& pool = stl_compatible::alloc();
+		int* block = a.allocate(10000);
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			std::thread([&a, block]() { a.deallocate(block, 10000); }).join();
+			REQUIRE(pool.remote_frees.load() != nullptr);
+			REQUIRE(pool.is_allocated(block));
+		}
+		int* other = a.allocate(10000);
+		THEN("Block is queued and released by the next pool user") {
+			REQUIRE(pool.remote_frees.load() == nullptr);
+			REQUIRE(pool.is_allocated(block) == (other == block));
+		}
+		a.deallocate(other, 10000);
+	}
+
+	WHEN("Vector outlives the cache of its thread") {
+		static std::atomic<bool> fell_back(false);
+		struct holder {
+			stl_compatible::vector<int> v;
+			~holder() {
+				fell_back = stl_compatible::thread_cache<stl_compatible::memory_pool>::destroyed();
+				v.push_back(100);
+			}
+		};
+		std::thread([]() {
+			static thread_local holder h;
+			for (int i = 0; i < 100; ++i) h.v.push_back(i);
+		}).join();
+		THEN("Vector is freed through the pool after the cache is gone") {
+			REQUIRE(fell_back);
+			REQUIRE(!stl_compatible::thread_cache<stl_compatible::memory_pool>::destroyed());
+		}
+	}
+}
+
 BENCHMARK("stl_compatible::vector, stl_compatible::allocator", [](benchpress::context* ctx) {
 	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
 		stl_compatible::vector<int> v;
@@ -549,6 +1589,60 @@ BENCHMARK("stl_compatible::vector, stl_compatible::allocator", [](benchpress::co
 	}
 })
 
+typedef stl_compatible::vector<int, stl_compatible::buddy_allocator<int>> vector_buddy_allocator;
+
+BENCHMARK("stl_compatible::vector, buddy_allocator", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_buddy_allocator v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+typedef stl_compatible::vector<int, stl_compatible::monotonic_allocator<int>> vector_monotonic_allocator;
+
+BENCHMARK("stl_compatible::vector, monotonic_allocator", [](benchpress::context* ctx) {
+	stl_compatible::monotonic_arena arena;
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		stl_compatible::monotonic_scope scope(arena);
+		vector_monotonic_allocator v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+typedef stl_compatible::stack_allocator<int, 4096> stack_allocator;
+typedef stl_compatible::vector<int, stack_allocator> vector_stack_allocator;
+
+BENCHMARK("stl_compatible::vector, stack_allocator, 500 items", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		stl_compatible::arena<4096> buffer;
+		vector_stack_allocator v{ stack_allocator(buffer) };
+		for (size_t i = 0; i < 500; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("stl_compatible::vector, stl_compatible::allocator, 500 items", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		stl_compatible::vector<int> v;
+		for (size_t i = 0; i < 500; ++i) v.push_back(i);
+	}
+})
+
+typedef stl_compatible::vector<int, stl_compatible::numa_allocator<int>> vector_numa_allocator;
+
+BENCHMARK("stl_compatible::vector, numa_allocator, 500 items", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_numa_allocator v;
+		for (size_t i = 0; i < 500; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("std::vector, std::allocator, 500 items", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		std::vector<int> v;
+		for (size_t i = 0; i < 500; ++i) v.push_back(i);
+	}
+})
+
 typedef stl_compatible::vector<int, std::allocator<int>> vector_std_allocator;
 
 BENCHMARK("stl_compatible::vector, std::allocator", [](benchpress::context* ctx) {
@@ -583,9 +1677,95 @@ BENCHMARK("std::vector, stl_compatible::allocator", [](benchpress::context* ctx)
 	}
 })
 
+struct growth_counters {
+	static std::size_t allocations, copied, live, peak;
+};
+
+std::size_t growth_counters::allocations, growth_counters::copied, growth_counters::live, growth_counters::peak;
+
+template<typename T>
+struct growth_probe : std::allocator<T> {
+
+	template<typename U>
+	struct rebind {
+		typedef growth_probe<U> other;
+	};
+
+	T* allocate(std::size_t n) {
+		++growth_counters::allocations;
+		growth_counters::live += n * sizeof(T);
+		growth_counters::peak = std::max(growth_counters::peak, growth_counters::live);
+		return std::allocator<T>::allocate(n);
+	}
+
+	void deallocate(T* p, std::size_t n) {
+		growth_counters::copied += n * sizeof(T);
+		growth_counters::live -= n * sizeof(T);
+		std::allocator<T>::deallocate(p, n);
+	}
+};
+
+template<typename Growth>
+void report_growth(const char* name) {
+	growth_counters::allocations = growth_counters::copied = growth_counters::live = growth_counters::peak = 0;
+	stl_compatible::vector<int, growth_probe<int>, Growth> v;
+	for (int i = 0; i < 100000; ++i) v.push_back(i);
+	std::cout << std::left << std::setw(28) << name
+		<< std::right << std::setw(8) << growth_counters::allocations - 1 << " reallocations"
+		<< std::setw(12) << growth_counters::copied << " bytes copied"
+		<< std::setw(12) << growth_counters::peak << " bytes peak" << std::endl;
+}
+
+typedef stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::one_and_half_growth> vector_one_and_half_growth;
+typedef stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::golden_growth> vector_golden_growth;
+typedef stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::page_growth> vector_page_growth;
+typedef stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::huge_page_growth> vector_huge_page_growth;
+typedef stl_compatible::vector<int, stl_compatible::allocator<int>, stl_compatible::fixed_growth<4096>> vector_fixed_growth;
+
+BENCHMARK("stl_compatible::vector, 1.5x growth", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_one_and_half_growth v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("stl_compatible::vector, golden ratio growth", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_golden_growth v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("stl_compatible::vector, page growth", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_page_growth v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("stl_compatible::vector, huge page growth", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_huge_page_growth v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
+BENCHMARK("stl_compatible::vector, fixed growth", [](benchpress::context* ctx) {
+	for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+		vector_fixed_growth v;
+		for (size_t i = 0; i < 100000; ++i) v.push_back(i);
+	}
+})
+
 int main(int argc, char** argv) {
 	int result = Catch::Session().run(argc, argv);
 	result = run(1, argv);
+	report_growth<stl_compatible::one_and_half_growth>("1.5x growth");
+	report_growth<stl_compatible::doubling_growth>("2x growth");
+	report_growth<stl_compatible::golden_growth>("golden ratio growth");
+	report_growth<stl_compatible::page_growth>("page growth");
+	report_growth<stl_compatible::huge_page_growth>("huge page growth");
+	report_growth<stl_compatible::fixed_growth<4096>>("fixed growth");
 	PAUSE;
 	return result;
 }
\ No newline at end of file
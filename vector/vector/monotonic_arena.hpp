@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "arena_provider.hpp"
+
+namespace stl_compatible {
+
+	class monotonic_arena {
+	public:
+		typedef char* pointer;
+		typedef std::size_t size_type;
+
+		static const size_type granularity = alignof(std::max_align_t);
+
+		monotonic_arena(arena_provider& provider = heap_arenas(), size_type chunk_size = size_type(1) << 16)
+			: provider(provider), chunk_size(chunk_size) {};
+		monotonic_arena(const monotonic_arena&) = delete;
+		monotonic_arena& operator=(const monotonic_arena&) = delete;
+		~monotonic_arena();
+
+		pointer allocate(size_type n, size_type alignment = granularity);
+		bool expand(void* p, size_type old_n, size_type new_n);
+		void reset() noexcept;
+		size_type used() const noexcept;
+
+	private:
+		struct chunk {
+
+			chunk* next;
+			size_type length;
+		};
+
+		arena_provider& provider;
+		size_type chunk_size;
+		chunk* first = nullptr;
+		chunk* current = nullptr;
+		pointer cursor = nullptr;
+		pointer limit = nullptr;
+		size_type finished = 0;
+
+		static pointer align(pointer p, size_type alignment);
+		void enter(chunk* c);
+	};
+
+	class monotonic_scope {
+	public:
+		monotonic_scope(monotonic_arena& arena) : arena(arena), previous(current()) { current() = &arena; };
+		monotonic_scope(const monotonic_scope&) = delete;
+		monotonic_scope& operator=(const monotonic_scope&) = delete;
+		~monotonic_scope();
+
+		static monotonic_arena*& current();
+
+	private:
+		monotonic_arena& arena;
+		monotonic_arena* previous;
+	};
+
+	template<typename T>
+	class monotonic_allocator {
+	public:
+		typedef T value_type;
+		typedef T* pointer;
+		typedef T& reference;
+		typedef size_t size_type;
+		typedef std::true_type propagate_on_container_swap;
+
+		template<typename U>
+		struct rebind {
+			typedef monotonic_allocator<U> other;
+		};
+
+		monotonic_allocator() : _arena(monotonic_scope::current()) {};
+		monotonic_allocator(monotonic_arena& arena) : _arena(&arena) {};
+		template<typename U>
+		monotonic_allocator(const monotonic_allocator<U>& other) : _arena(other.arena()) {};
+
+		pointer allocate(size_type n);
+		void deallocate(pointer, size_type) {};
+		bool try_expand(pointer p, size_type old_n, size_type new_n);
+		void destroy(pointer p);
+		monotonic_arena* arena() const { return _arena; };
+
+		template <typename... Types>
+		void construct(pointer p, Types&&... t) {
+			::new (static_cast<void*>(p)) value_type(std::forward<Types>(t)...);
+		};
+
+	private:
+		monotonic_arena* _arena;
+	};
+
+	inline monotonic_arena::~monotonic_arena() {
+		while (first != nullptr) {
+			chunk* next = first->next;
+			provider.release(first, first->length);
+			first = next;
+		}
+	}
+
+	inline monotonic_arena::pointer monotonic_arena::align(pointer p, size_type alignment) {
+		return p + (alignment - reinterpret_cast<std::uintptr_t>(p) % alignment) % alignment;
+	}
+
+	inline void monotonic_arena::enter(chunk* c) {
+		if (current != nullptr) finished += cursor - reinterpret_cast<pointer>(current + 1);
+		current = c;
+		cursor = reinterpret_cast<pointer>(c + 1);
+		limit = reinterpret_cast<pointer>(c) + c->length;
+	}
+
+	inline monotonic_arena::pointer monotonic_arena::allocate(size_type n, size_type alignment) {
+		alignment = std::max(alignment, size_type(granularity));
+		pointer p = align(cursor, alignment);
+		if (current != nullptr && n <= size_type(limit - cursor) && size_type(p - cursor) <= size_type(limit - cursor) - n) {
+			cursor = p + n;
+			return p;
+		}
+		while (current != nullptr && current->next != nullptr) {
+			enter(current->next);
+			p = align(cursor, alignment);
+			if (n <= size_type(limit - cursor) && size_type(p - cursor) <= size_type(limit - cursor) - n) {
+				cursor = p + n;
+				return p;
+			}
+		}
+		if (n > size_type(-1) / 2 - sizeof(chunk) - alignment) throw std::bad_alloc();
+		size_type length = std::max(chunk_size, n + sizeof(chunk) + alignment);
+		void* memory = provider.reserve(length);
+		if (!provider.commit(memory, length)) {
+			provider.release(memory, length);
+			throw std::bad_alloc();
+		}
+		chunk* c = ::new (memory) chunk{ nullptr, length };
+		if (current == nullptr) first = c;
+		else current->next = c;
+		chunk_size = std::min(chunk_size * 2, size_type(1) << 26);
+		enter(c);
+		p = align(cursor, alignment);
+		cursor = p + n;
+		return p;
+	}
+
+	inline bool monotonic_arena::expand(void* p, size_type old_n, size_type new_n) {
+		if (static_cast<pointer>(p) + old_n != cursor || new_n < old_n || new_n - old_n > size_type(limit - cursor)) return false;
+		cursor += new_n - old_n;
+		return true;
+	}
+
+	inline void monotonic_arena::reset() noexcept {
+		current = nullptr;
+		finished = 0;
+		if (first != nullptr) enter(first);
+	}
+
+	inline monotonic_arena::size_type monotonic_arena::used() const noexcept {
+		return current == nullptr ? 0 : finished + (cursor - reinterpret_cast<const char*>(current + 1));
+	}
+
+	inline monotonic_scope::~monotonic_scope() {
+		arena.reset();
+		current() = previous;
+	}
+
+	inline monotonic_arena*& monotonic_scope::current() {
+		static thread_local monotonic_arena* arena = nullptr;
+		return arena;
+	}
+
+	template<typename T>
+	typename monotonic_allocator<T>::pointer monotonic_allocator<T>::allocate(size_type n) {
+		if (_arena == nullptr || n > (size_type)(-1) / sizeof(T)) throw std::bad_alloc();
+		return reinterpret_cast<pointer>(_arena->allocate(n * sizeof(T), alignof(T)));
+	};
+
+	template<typename T>
+	bool monotonic_allocator<T>::try_expand(pointer p, size_type old_n, size_type new_n) {
+		if (_arena == nullptr || new_n > (size_type)(-1) / sizeof(T)) return false;
+		return _arena->expand(p, old_n * sizeof(T), new_n * sizeof(T));
+	};
+
+	template<typename T>
+	void monotonic_allocator<T>::destroy(pointer p) { p->~value_type(); };
+
+	template<typename T, typename U>
+	bool operator==(const monotonic_allocator<T>& a, const monotonic_allocator<U>& b) { return a.arena() == b.arena(); }
+
+	template<typename T, typename U>
+	bool operator!=(const monotonic_allocator<T>& a, const monotonic_allocator<U>& b) { return !(a == b); }
+
+}
\ No newline at end of file
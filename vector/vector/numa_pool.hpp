@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "allocator.hpp"
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace stl_compatible {
+
+	class node_arena_provider : public mapped_arena_provider {
+	public:
+		static const std::size_t max_arenas = 64;
+
+		std::size_t node;
+
+		node_arena_provider(std::size_t node) : node(node) {};
+
+		void* reserve(std::size_t& length) override;
+		bool owns(const void* p) const;
+
+	private:
+		struct arena_range {
+
+			const char* begin;
+			std::size_t length;
+		};
+
+		arena_range ranges[max_arenas] = {};
+		std::atomic<std::size_t> count{ 0 };
+
+		void* reserve_on_node(std::size_t& length);
+	};
+
+	struct numa_pool : remote_free_queue {
+
+		typedef memory_pool::pointer pointer;
+		typedef memory_pool::size_type size_type;
+		typedef null_mutex mutex_type;
+
+		static const size_type granularity = memory_pool::granularity;
+
+		std::vector<std::unique_ptr<node_arena_provider>> providers;
+		std::vector<std::unique_ptr<memory_pool>> nodes;
+		null_mutex mutex;
+
+		numa_pool(size_type count = numa_nodes());
+
+		pointer allocate(size_type n, size_type alignment = granularity);
+		void deallocate(void* p, size_type n);
+		bool expand(void* p, size_type n);
+		bool shrink(void* p, size_type n);
+
+		void drain_remote_frees();
+		memory_pool& local_pool();
+		memory_pool* owner(const void* p);
+
+		static size_type numa_nodes();
+		static size_type current_node();
+
+	private:
+		static const size_type node_refresh = 256;
+
+		static size_type cpu_node();
+	};
+
+	template<>
+	struct thread_cached<numa_pool> : std::false_type {};
+
+	template<typename T>
+	using numa_allocator = allocator<T, alignof(T), numa_pool>;
+
+#if defined(_WIN32)
+	inline void* node_arena_provider::reserve_on_node(std::size_t& length) {
+		length = round_up(length, page_size());
+		void* p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, static_cast<DWORD>(node));
+		if (p == nullptr) return mapped_arena_provider::reserve(length);
+		return p;
+	}
+
+	inline numa_pool::size_type numa_pool::numa_nodes() {
+		ULONG highest = 0;
+		if (!GetNumaHighestNodeNumber(&highest)) return 1;
+		return highest + 1;
+	}
+
+	inline numa_pool::size_type numa_pool::cpu_node() {
+		PROCESSOR_NUMBER processor;
+		USHORT node = 0;
+		GetCurrentProcessorNumberEx(&processor);
+		if (!GetNumaProcessorNodeEx(&processor, &node)) return 0;
+		return node;
+	}
+#else
+	inline void* node_arena_provider::reserve_on_node(std::size_t& length) {
+		void* p = mapped_arena_provider::reserve(length);
+#if defined(__linux__) && defined(SYS_mbind)
+		const std::size_t bits = sizeof(unsigned long) * 8, preferred = 1;
+		std::vector<unsigned long> mask(node / bits + 1, 0);
+		mask[node / bits] = 1ul << (node % bits);
+		syscall(SYS_mbind, p, length, preferred, mask.data(), mask.size() * bits + 1, 0);
+#endif
+		return p;
+	}
+
+	inline numa_pool::size_type numa_pool::numa_nodes() {
+		std::ifstream online("/sys/devices/system/node/online");
+		std::string ranges;
+		if (!(online >> ranges)) return 1;
+		size_type highest = 0, value = 0;
+		for (char c : ranges) {
+			if (c >= '0' && c <= '9') value = value * 10 + (c - '0');
+			else value = 0;
+			highest = std::max(highest, value);
+		}
+		return highest + 1;
+	}
+
+	inline numa_pool::size_type numa_pool::cpu_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+		unsigned cpu = 0, node = 0;
+		if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return node;
+#endif
+		return 0;
+	}
+#endif
+
+	inline void* node_arena_provider::reserve(std::size_t& length) {
+		std::size_t index = count.load(std::memory_order_relaxed);
+		if (index == max_arenas) throw std::bad_alloc();
+		void* p = reserve_on_node(length);
+		ranges[index] = { static_cast<const char*>(p), length };
+		count.store(index + 1, std::memory_order_release);
+		return p;
+	}
+
+	inline bool node_arena_provider::owns(const void* p) const {
+		const char* address = static_cast<const char*>(p);
+		for (std::size_t i = 0, n = count.load(std::memory_order_acquire); i < n; ++i)
+			if (address >= ranges[i].begin && address < ranges[i].begin + ranges[i].length) return true;
+		return false;
+	}
+
+	inline numa_pool::size_type numa_pool::current_node() {
+		static thread_local size_type node = 0, calls = 0;
+		if (calls++ % node_refresh == 0) node = cpu_node();
+		return node;
+	}
+
+	inline numa_pool::numa_pool(size_type count) {
+		count = std::max(count, size_type(1));
+		for (size_type node = 0; node < count; ++node) {
+			providers.emplace_back(new node_arena_provider(node));
+			nodes.emplace_back(new memory_pool(*providers.back()));
+		}
+	}
+
+	inline memory_pool& numa_pool::local_pool() {
+		size_type node = current_node();
+		return *nodes[node < nodes.size() ? node : 0];
+	}
+
+	inline memory_pool* numa_pool::owner(const void* p) {
+		for (size_type node = 0; node < nodes.size(); ++node)
+			if (providers[node]->owns(p)) return nodes[node].get();
+		return nullptr;
+	}
+
+	inline void numa_pool::drain_remote_frees() {
+		drain(*this);
+	}
+
+	inline numa_pool::pointer numa_pool::allocate(size_type n, size_type alignment) {
+		if (remote_frees.load(std::memory_order_relaxed) != nullptr) drain_remote_frees();
+		memory_pool& pool = local_pool();
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		return pool.allocate(n, alignment);
+	}
+
+	inline void numa_pool::deallocate(void* p, size_type n) {
+		memory_pool* pool = p == nullptr ? nullptr : owner(p);
+		if (pool == nullptr) return;
+		std::unique_lock<std::mutex> lock(pool->mutex, std::try_to_lock);
+		if (!lock.owns_lock()) {
+			if (pool->can_defer(p, n)) return pool->defer_deallocate(p, n);
+			lock.lock();
+		}
+		pool->deallocate(p, n);
+	}
+
+	inline bool numa_pool::expand(void* p, size_type n) {
+		memory_pool* pool = owner(p);
+		if (pool == nullptr) return false;
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		return pool->expand(p, n);
+	}
+
+	inline bool numa_pool::shrink(void* p, size_type n) {
+		memory_pool* pool = owner(p);
+		if (pool == nullptr) return false;
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		return pool->shrink(p, n);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include "allocator.hpp"
+#include "vector.hpp"
+
+namespace stl_compatible {
+
+	template<typename Pool = memory_pool>
+	class pool_resource : public std::pmr::memory_resource {
+	public:
+		pool_resource(Pool& pool = alloc<Pool>()) : pool(pool) {};
+
+		Pool& upstream() const noexcept { return pool; };
+
+	protected:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	private:
+		Pool& pool;
+
+		bool is_cached(std::size_t bytes, std::size_t alignment) const;
+	};
+
+	template<typename Pool = memory_pool>
+	std::pmr::memory_resource* pool_memory_resource() {
+		static pool_resource<Pool> resource;
+		return &resource;
+	}
+
+	namespace pmr {
+
+		template<typename T>
+		using vector = stl_compatible::vector<T, std::pmr::polymorphic_allocator<T>>;
+
+	}
+
+	template<typename Pool>
+	bool pool_resource<Pool>::is_cached(std::size_t bytes, std::size_t alignment) const {
+		return &pool == &alloc<Pool>() && alignment <= Pool::granularity && thread_cache<Pool>::is_cached(bytes);
+	}
+
+	template<typename Pool>
+	void* pool_resource<Pool>::do_allocate(std::size_t bytes, std::size_t alignment) {
+		if (is_cached(bytes, alignment)) return cached_allocate<Pool>(bytes);
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		return pool.allocate(bytes, alignment);
+	}
+
+	template<typename Pool>
+	void pool_resource<Pool>::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+		if (is_cached(bytes, alignment)) return cached_deallocate<Pool>(p, bytes);
+		std::lock_guard<typename Pool::mutex_type> lock(pool.mutex);
+		pool.deallocate(p, bytes);
+	}
+
+	template<typename Pool>
+	bool pool_resource<Pool>::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		const pool_resource<Pool>* resource = dynamic_cast<const pool_resource<Pool>*>(&other);
+		return resource != nullptr && &resource->pool == &pool;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace stl_compatible {
+
+	struct pool_stats {
+
+		std::size_t reserved = 0;
+		std::size_t live_bytes = 0;
+		std::size_t high_water = 0;
+		std::size_t free_blocks = 0;
+		std::size_t largest_free = 0;
+		std::size_t allocations = 0;
+		std::size_t deallocations = 0;
+		std::size_t splits = 0;
+		std::size_t coalesces = 0;
+		std::size_t trimmed = 0;
+		std::size_t cached_allocations = 0;
+		std::size_t cached_deallocations = 0;
+		std::size_t cached_bytes = 0;
+
+		pool_stats& operator+=(const pool_stats& other);
+	};
+
+	struct cache_counters {
+
+		std::atomic<std::size_t> allocations{ 0 };
+		std::atomic<std::size_t> deallocations{ 0 };
+		std::atomic<std::size_t> allocated_bytes{ 0 };
+		std::atomic<std::size_t> freed_bytes{ 0 };
+
+		void count_allocation(std::size_t n);
+		void count_deallocation(std::size_t n);
+
+	private:
+		static void add(std::atomic<std::size_t>& counter, std::size_t n);
+	};
+
+	class stats_source {
+	public:
+		std::ostream* dump_stream = nullptr;
+		std::size_t dump_interval = 0;
+
+		virtual ~stats_source() {};
+		virtual pool_stats stats() = 0;
+		virtual pool_stats snapshot() const = 0;
+
+		void attach_cache(const cache_counters* cache);
+		void detach_cache(const cache_counters* cache);
+
+	protected:
+		pool_stats counters;
+		std::vector<const cache_counters*> caches;
+
+		void count_allocation(std::size_t n);
+		void count_deallocation(std::size_t n);
+		void merge_caches(pool_stats& snapshot) const;
+		void dump(const pool_stats& snapshot);
+
+	private:
+		static void fold(pool_stats& snapshot, const cache_counters& cache);
+	};
+
+	struct stats_registry {
+
+		std::mutex mutex;
+		std::vector<stats_source*> sources;
+
+		void add(stats_source* source);
+		void remove(stats_source* source);
+	};
+
+	inline stats_registry& registered_pools() {
+		static stats_registry registry;
+		return registry;
+	}
+
+	inline pool_stats total_stats() {
+		stats_registry& registry = registered_pools();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		pool_stats total;
+		for (auto source : registry.sources) total += source->stats();
+		return total;
+	}
+
+	inline pool_stats& pool_stats::operator+=(const pool_stats& other) {
+		reserved += other.reserved;
+		live_bytes += other.live_bytes;
+		high_water = std::max(high_water, other.high_water);
+		free_blocks += other.free_blocks;
+		largest_free = std::max(largest_free, other.largest_free);
+		allocations += other.allocations;
+		deallocations += other.deallocations;
+		splits += other.splits;
+		coalesces += other.coalesces;
+		trimmed += other.trimmed;
+		cached_allocations += other.cached_allocations;
+		cached_deallocations += other.cached_deallocations;
+		cached_bytes += other.cached_bytes;
+		return *this;
+	}
+
+	inline std::ostream& operator<<(std::ostream& out, const pool_stats& stats) {
+		return out << "reserved " << stats.reserved
+			<< ", live " << stats.live_bytes
+			<< ", high water " << stats.high_water
+			<< ", free blocks " << stats.free_blocks
+			<< ", largest free " << stats.largest_free
+			<< ", allocations " << stats.allocations
+			<< ", deallocations " << stats.deallocations
+			<< ", splits " << stats.splits
+			<< ", coalesces " << stats.coalesces
+			<< ", trimmed " << stats.trimmed
+			<< ", cached allocations " << stats.cached_allocations
+			<< ", cached deallocations " << stats.cached_deallocations
+			<< ", cached live " << stats.cached_bytes;
+	}
+
+	inline void cache_counters::add(std::atomic<std::size_t>& counter, std::size_t n) {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	inline void cache_counters::count_allocation(std::size_t n) {
+		add(allocations, 1);
+		add(allocated_bytes, n);
+	}
+
+	inline void cache_counters::count_deallocation(std::size_t n) {
+		add(deallocations, 1);
+		add(freed_bytes, n);
+	}
+
+	inline void stats_source::count_allocation(std::size_t n) {
+		++counters.allocations;
+		counters.live_bytes += n;
+		counters.high_water = std::max(counters.high_water, counters.live_bytes);
+		if (dump_stream != nullptr && dump_interval != 0 && counters.allocations % dump_interval == 0) dump(snapshot());
+	}
+
+	inline void stats_source::count_deallocation(std::size_t n) {
+		++counters.deallocations;
+		counters.live_bytes -= n;
+	}
+
+	inline void stats_source::attach_cache(const cache_counters* cache) {
+		caches.push_back(cache);
+	}
+
+	inline void stats_source::detach_cache(const cache_counters* cache) {
+		fold(counters, *cache);
+		caches.erase(std::remove(caches.begin(), caches.end(), cache), caches.end());
+	}
+
+	inline void stats_source::merge_caches(pool_stats& snapshot) const {
+		for (auto cache : caches) fold(snapshot, *cache);
+	}
+
+	inline void stats_source::fold(pool_stats& snapshot, const cache_counters& cache) {
+		snapshot.cached_allocations += cache.allocations.load(std::memory_order_relaxed);
+		snapshot.cached_deallocations += cache.deallocations.load(std::memory_order_relaxed);
+		snapshot.cached_bytes += cache.allocated_bytes.load(std::memory_order_relaxed) - cache.freed_bytes.load(std::memory_order_relaxed);
+	}
+
+	inline void stats_source::dump(const pool_stats& snapshot) {
+		*dump_stream << snapshot << '\n';
+	}
+
+	inline void stats_registry::add(stats_source* source) {
+		std::lock_guard<std::mutex> lock(mutex);
+		sources.push_back(source);
+	}
+
+	inline void stats_registry::remove(stats_source* source) {
+		std::lock_guard<std::mutex> lock(mutex);
+		sources.erase(std::remove(sources.begin(), sources.end(), source), sources.end());
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "allocator.hpp"
+#include "buddy_pool.hpp"
+#include "allocation_trace.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+template<typename Pool>
+void run(const std::string& name, const std::vector<stl_compatible::trace_record>& trace, Pool& pool) {
+	stl_compatible::replay_result result = stl_compatible::replay(trace, pool);
+	std::cout << name << ": " << result.seconds * 1e3 << " ms" << std::endl;
+	std::cout << "  " << pool.stats() << std::endl;
+	std::cout << "  fragmentation at peak " << result.fragmentation << std::endl;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: replay <trace> [initial pool bytes]" << std::endl;
+		return 1;
+	}
+	std::ifstream in(argv[1], std::ios::binary);
+	std::vector<stl_compatible::trace_record> trace;
+	try {
+		trace = stl_compatible::read_trace(in);
+	}
+	catch (const std::exception& e) {
+		std::cerr << argv[1] << ": " << e.what() << std::endl;
+		return 1;
+	}
+	std::size_t size = argc > 2 ? std::stoull(argv[2]) : stl_compatible::configured_pool_size();
+	std::cout << trace.size() << " records" << std::endl;
+	{
+		stl_compatible::memory_pool pool;
+		pool.default_size = size;
+		run("memory_pool, size classes", trace, pool);
+	}
+	{
+		stl_compatible::memory_pool pool(stl_compatible::default_arena_provider(), stl_compatible::fit_policy::best_fit);
+		pool.default_size = size;
+		run("memory_pool, best fit", trace, pool);
+	}
+	{
+		stl_compatible::buddy_pool pool;
+		pool.arena_order = stl_compatible::buddy_pool::order_of(size);
+		run("buddy_pool", trace, pool);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "allocator.hpp"
+
+namespace stl_compatible {
+
+	template<std::size_t N>
+	class arena {
+	public:
+		typedef char* pointer;
+		typedef std::size_t size_type;
+
+		static const size_type capacity = N;
+
+		arena() : cursor(buffer) {};
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		pointer allocate(size_type n, size_type alignment);
+		void deallocate(void* p, size_type n);
+		bool expand(void* p, size_type old_n, size_type new_n);
+		bool owns(const void* p) const noexcept;
+		size_type used() const noexcept;
+		void reset() noexcept;
+
+	private:
+		alignas(std::max_align_t) char buffer[N];
+		pointer cursor;
+	};
+
+	template<typename T, std::size_t N, typename Overflow = allocator<T>>
+	class stack_allocator {
+	public:
+		typedef T value_type;
+		typedef T* pointer;
+		typedef T& reference;
+		typedef size_t size_type;
+		typedef std::true_type propagate_on_container_swap;
+
+		template<typename U>
+		struct rebind {
+			typedef stack_allocator<U, N, typename std::allocator_traits<Overflow>::template rebind_alloc<U>> other;
+		};
+
+		stack_allocator(arena<N>& buffer) : _arena(&buffer) {};
+		template<typename U, typename O>
+		stack_allocator(const stack_allocator<U, N, O>& other) : _arena(other.get_arena()), _overflow(other.get_overflow()) {};
+
+		pointer allocate(size_type n);
+		void deallocate(pointer p, size_type n);
+		bool try_expand(pointer p, size_type old_n, size_type new_n);
+		bool try_shrink(pointer p, size_type old_n, size_type new_n);
+		void destroy(pointer p);
+		arena<N>* get_arena() const { return _arena; };
+		const Overflow& get_overflow() const { return _overflow; };
+
+		template <typename... Types>
+		void construct(pointer p, Types&&... t) {
+			::new (static_cast<void*>(p)) value_type(std::forward<Types>(t)...);
+		};
+
+	private:
+		arena<N>* _arena;
+		Overflow _overflow;
+	};
+
+	template<std::size_t N>
+	typename arena<N>::pointer arena<N>::allocate(size_type n, size_type alignment) {
+		size_type offset = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+		if (n > size_type(buffer + N - cursor) || offset > size_type(buffer + N - cursor) - n) return nullptr;
+		pointer p = cursor + offset;
+		cursor = p + n;
+		return p;
+	}
+
+	template<std::size_t N>
+	void arena<N>::deallocate(void* p, size_type n) {
+		if (static_cast<pointer>(p) + n == cursor) cursor = static_cast<pointer>(p);
+	}
+
+	template<std::size_t N>
+	bool arena<N>::expand(void* p, size_type old_n, size_type new_n) {
+		if (static_cast<pointer>(p) + old_n != cursor || new_n < old_n || new_n - old_n > size_type(buffer + N - cursor)) return false;
+		cursor += new_n - old_n;
+		return true;
+	}
+
+	template<std::size_t N>
+	bool arena<N>::owns(const void* p) const noexcept {
+		return static_cast<const char*>(p) >= buffer && static_cast<const char*>(p) <= buffer + N;
+	}
+
+	template<std::size_t N>
+	typename arena<N>::size_type arena<N>::used() const noexcept {
+		return cursor - buffer;
+	}
+
+	template<std::size_t N>
+	void arena<N>::reset() noexcept {
+		cursor = buffer;
+	}
+
+	template<typename T, std::size_t N, typename Overflow>
+	typename stack_allocator<T, N, Overflow>::pointer stack_allocator<T, N, Overflow>::allocate(size_type n) {
+		if (n <= N / sizeof(T))
+			if (char* p = _arena->allocate(n * sizeof(T), alignof(T))) return reinterpret_cast<pointer>(p);
+		return _overflow.allocate(n);
+	};
+
+	template<typename T, std::size_t N, typename Overflow>
+	void stack_allocator<T, N, Overflow>::deallocate(pointer p, size_type n) {
+		if (_arena->owns(p)) _arena->deallocate(p, n * sizeof(T));
+		else _overflow.deallocate(p, n);
+	};
+
+	template<typename T, std::size_t N, typename Overflow>
+	bool stack_allocator<T, N, Overflow>::try_expand(pointer p, size_type old_n, size_type new_n) {
+		if (!_arena->owns(p)) return expand_in_place(_overflow, p, old_n, new_n);
+		return new_n <= N / sizeof(T) && _arena->expand(p, old_n * sizeof(T), new_n * sizeof(T));
+	};
+
+	template<typename T, std::size_t N, typename Overflow>
+	bool stack_allocator<T, N, Overflow>::try_shrink(pointer p, size_type old_n, size_type new_n) {
+		if (!_arena->owns(p)) return shrink_in_place(_overflow, p, old_n, new_n);
+		return false;
+	};
+
+	template<typename T, std::size_t N, typename Overflow>
+	void stack_allocator<T, N, Overflow>::destroy(pointer p) { p->~value_type(); };
+
+	template<typename T, std::size_t N, typename O, typename U, typename P>
+	bool operator==(const stack_allocator<T, N, O>& a, const stack_allocator<U, N, P>& b) { return a.get_arena() == b.get_arena(); }
+
+	template<typename T, std::size_t N, typename O, typename U, typename P>
+	bool operator!=(const stack_allocator<T, N, O>& a, const stack_allocator<U, N, P>& b) { return !(a == b); }
+
+}
\ No newline at end of file
@@ -1,21 +1,29 @@
 #pragma once
 #include <algorithm>
+#include <cstring>
 #include <exception>
 #include <stdexcept>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <type_traits>
 #include "allocator.hpp"
+#include "growth_policy.hpp"
 
 namespace stl_compatible {
 
 	class exception : public std::exception {};
 
-	template<typename T, typename A = allocator<T>>
+	template<typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+	template<typename T, typename A = allocator<T>, typename G = doubling_growth>
 	class vector {
 	public:
 		typedef std::size_t size_type;
 		typedef T value_type;
 		typedef A allocator_type;
+		typedef G growth_policy;
 
 		struct iterator : public std::iterator<std::random_access_iterator_tag, T> {
 		public:
@@ -53,7 +61,9 @@ namespace stl_compatible {
 		};
 
 		vector() {};
-		vector(const vector<T>&);
+		explicit vector(const A&);
+		vector(const vector<T, A, G>&);
+		vector(vector<T, A, G>&&) noexcept;
 		vector(size_type);
 		vector(size_type, const T&);
 		vector(std::initializer_list<T>);
@@ -63,9 +73,9 @@ namespace stl_compatible {
 
 		~vector();
 
-		vector<T, A>& operator=(const vector<T, A>&);
-		vector<T, A>& operator=(vector<T, A>&&);
-		vector<T, A>& operator=(std::initializer_list<T>);
+		vector<T, A, G>& operator=(const vector<T, A, G>&);
+		vector<T, A, G>& operator=(vector<T, A, G>&&);
+		vector<T, A, G>& operator=(std::initializer_list<T>);
 
 		iterator begin() noexcept;
 		iterator end() noexcept;
@@ -95,7 +105,7 @@ namespace stl_compatible {
 		iterator insert(iterator, std::initializer_list<T>);
 		iterator erase(iterator);
 		iterator erase(iterator, iterator);
-		void swap(vector<T, A>&);
+		void swap(vector<T, A, G>&);
 		void clear() noexcept;
 
 		template<typename... Types>
@@ -116,51 +126,77 @@ namespace stl_compatible {
 		A allocator;
 		T* _begin = nullptr, *_last = nullptr, *_end = nullptr;
 
-		const int allocation_multiplier = 2;
-
-		void reallocate(size_type s);
+		void reallocate(size_type);
+		size_type next_capacity(size_type) const;
+		void relocate(T*, T*, T*, std::true_type);
+		void relocate(T*, T*, T*, std::false_type);
+		void shift(T*, T*, T*, std::true_type);
+		void shift(T*, T*, T*, std::false_type);
+		T* open_gap(size_type, size_type);
+		void close_gap(T*, size_type, size_type);
 		void initialize(iterator, iterator);
 		void destroy(iterator, iterator);
+		bool shares_allocator(const vector<T, A, G>&) const;
+		void swap_buffers(vector<T, A, G>&) noexcept;
+		void swap_allocator(vector<T, A, G>&, std::true_type);
+		void swap_allocator(vector<T, A, G>&, std::false_type) {};
+		void copy_allocator(const vector<T, A, G>&, std::true_type);
+		void copy_allocator(const vector<T, A, G>&, std::false_type) {};
+		void move_allocator(vector<T, A, G>&, std::true_type);
+		void move_allocator(vector<T, A, G>&, std::false_type) {};
 	};
 
-	template<typename T, typename A>
-	vector<T, A>::vector(const vector<T>& other) {
+	template<typename T, typename A, typename G>
+	struct is_trivially_relocatable<vector<T, A, G>> : is_trivially_relocatable<A> {};
+
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(const A& other) : allocator(other) {}
+
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(const vector<T, A, G>& other) : allocator(std::allocator_traits<A>::select_on_container_copy_construction(other.allocator)) {
 		reallocate(other.size());
 		for (size_type i = 0; i < other.size(); ++i) allocator.construct(_begin + i, other[i]);
+		_last = _begin + other.size();
 	}
 
-	template<typename T, typename A>
-	vector<T, A>::vector(size_type new_size) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(vector<T, A, G>&& other) noexcept : allocator(other.allocator) {
+		swap_buffers(other);
+	}
+
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(size_type new_size) {
 		reallocate(new_size);
 		_last = _begin + new_size;
 		initialize(begin(), end());
 	}
 
-	template<typename T, typename A>
-	vector<T, A>::vector(size_type new_size, const T& value) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(size_type new_size, const T& value) {
 		assign(new_size, value);
 	}
 
-	template<typename T, typename A>
-	vector<T, A>::vector(std::initializer_list<T> il) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::vector(std::initializer_list<T> il) {
 		assign(il.begin(), il.end());
 	}
 
-	template<typename T, typename A>
+	template<typename T, typename A, typename G>
 	template<typename InputIterator>
-	vector<T, A>::vector(InputIterator first, InputIterator last) {
+	vector<T, A, G>::vector(InputIterator first, InputIterator last) {
 		assign(first, last);
 	}
 
-	template<typename T, typename A>
-	vector<T, A>::~vector() {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>::~vector() {
 		destroy(begin(), end());
 		allocator.deallocate(_begin, capacity());
 	}
 
-	template<typename T, typename A>
-	vector<T, A>& vector<T, A>::operator=(const vector<T, A>& other) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>& vector<T, A, G>::operator=(const vector<T, A, G>& other) {
 		if (this == &other) return *this;
+		copy_allocator(other, typename std::allocator_traits<A>::propagate_on_container_copy_assignment());
 		erase(begin(), end());
 		if (other.size() > capacity()) reallocate(other.size());
 		for (size_type i = 0; i < other.size(); ++i) allocator.construct(_begin + i, other[i]);
@@ -168,263 +204,386 @@ namespace stl_compatible {
 		return *this;
 	}
 
-	template<typename T, typename A>
-	vector<T, A>& vector<T, A>::operator=(vector<T, A>&& other) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>& vector<T, A, G>::operator=(vector<T, A, G>&& other) {
 		if (this == &other) return *this;
+		if (!std::allocator_traits<A>::propagate_on_container_move_assignment::value && !shares_allocator(other)) {
+			assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+			return *this;
+		}
+		destroy(begin(), end());
 		clear();
-		swap(other);
+		move_allocator(other, typename std::allocator_traits<A>::propagate_on_container_move_assignment());
+		swap_buffers(other);
 		return *this;
 	}
 
-	template<typename T, typename A>
-	vector<T, A>& vector<T, A>::operator=(std::initializer_list<T> other) {
+	template<typename T, typename A, typename G>
+	vector<T, A, G>& vector<T, A, G>::operator=(std::initializer_list<T> other) {
 		assign(other.begin(), other.end());
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::begin() noexcept {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::begin() noexcept {
 		return iterator(_begin);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::end() noexcept {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::end() noexcept {
 		return iterator(_last);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::assign(size_type n, const T& value) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::assign(size_type n, const T& value) {
 		erase(begin(), end());
 		if (n > capacity()) reallocate(n);
 		for (size_type i = 0; i < n; ++i) allocator.construct(_begin + i, value);
 		_last = _begin + n;
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::assign(std::initializer_list<T> il) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::assign(std::initializer_list<T> il) {
 		assign(il.begin(), il.end());
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::push_back(const T& value) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::push_back(const T& value) {
 		size_type new_size = size() + 1;
-		if (new_size >= capacity()) reallocate(new_size);
-		allocator.construct(_last++, T(value));
+		if (new_size > capacity()) return push_back(T(value));
+		allocator.construct(_last++, value);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::push_back(T&& value) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::push_back(T&& value) {
 		size_type new_size = size() + 1;
-		if (new_size >= capacity()) reallocate(new_size);
-		std::swap(*(_last++), value);
+		if (new_size > capacity()) {
+			T moved(std::move(value));
+			reallocate(next_capacity(new_size));
+			allocator.construct(_last++, std::move(moved));
+			return;
+		}
+		allocator.construct(_last++, std::move(value));
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::pop_back() {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::pop_back() {
 		allocator.destroy(_last);
 		--_last;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::insert(iterator it, const T& value) {
-		size_type new_size = size() + 1;
-		size_type index = it - begin();
-		if (new_size > capacity()) reallocate(new_size);
-		it = begin() + index;
-		std::copy_backward(it, end(), it + size() - index + 1);
-		*it = value;
-		++_last;
-		return it;
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::insert(iterator it, const T& value) {
+		return insert(it, size_type(1), value);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::insert(iterator it, size_type n, const T& value) {
-		size_type new_size = size() + n;
-		size_type index = it - begin();
-		if (new_size > capacity()) reallocate(new_size);
-		it = begin() + index;
-		std::copy_backward(it, end(), it + n + size() - index);
-		std::fill(it, it + n, value);
-		_last = _begin + new_size;
-		return it;
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::insert(iterator it, size_type n, const T& value) {
+		if (n == 0) return it;
+		if (&value >= _begin && &value < _last) return insert(it, n, T(value));
+		T* gap = open_gap(it - begin(), n);
+		size_type built = 0;
+		try {
+			for (; built < n; ++built) allocator.construct(gap + built, value);
+		}
+		catch (...) {
+			close_gap(gap, n, built);
+			throw;
+		}
+		return iterator(gap);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::insert(iterator it, std::initializer_list<T> il) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::insert(iterator it, std::initializer_list<T> il) {
 		return insert(it, il.begin(), il.end());
 	}
 
-	template<typename T, typename A>
+	template<typename T, typename A, typename G>
 	template<typename InputIterator>
-	typename vector<T, A>::iterator vector<T, A>::insert(typename vector<T, A>::iterator from, InputIterator first, InputIterator last) {
-		typename std::iterator_traits<InputIterator>::difference_type n = std::distance(first, last);
-		size_type new_size = size() + n;
-		size_type index = from - begin();
-		if (new_size > capacity()) reallocate(new_size);
-		from = begin() + index;
-		std::copy_backward(from, end(), from + n + size() - index);
-		std::copy(first, last, from);
-		_last = _begin + new_size;
-		return from;
+	typename vector<T, A, G>::iterator vector<T, A, G>::insert(typename vector<T, A, G>::iterator from, InputIterator first, InputIterator last) {
+		size_type n = std::distance(first, last);
+		T* gap = open_gap(from - begin(), n);
+		size_type built = 0;
+		try {
+			for (; first != last; ++first, ++built) allocator.construct(gap + built, *first);
+		}
+		catch (...) {
+			close_gap(gap, n, built);
+			throw;
+		}
+		return iterator(gap);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::erase(iterator it) {
-		allocator.destroy(&*it);
-		std::copy(it + 1, end(), it);
-		--_last;
-		return it;
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::erase(iterator it) {
+		return erase(it, it + 1);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::erase(iterator first, iterator last) {
-		for (iterator it = first; it != last; ++it) allocator.destroy(&*it);
-		if (end() > last + 1) std::copy(last + 1, end(), first + 1);
-		_last -= std::distance(first, last);
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::erase(iterator first, iterator last) {
+		if (first == last) return first;
+		destroy(first, last);
+		shift(_begin + (last - begin()), _last, _begin + (first - begin()), typename is_trivially_relocatable<T>::type());
+		_last -= last - first;
 		return first;
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::swap(vector<T, A>& other) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::swap(vector<T, A, G>& other) {
+		if (!std::allocator_traits<A>::propagate_on_container_swap::value && !shares_allocator(other)) {
+			vector<T, A, G> mine(allocator), theirs(other.allocator);
+			mine.assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+			theirs.assign(std::make_move_iterator(begin()), std::make_move_iterator(end()));
+			swap_buffers(mine);
+			other.swap_buffers(theirs);
+			return;
+		}
+		swap_buffers(other);
+		swap_allocator(other, typename std::allocator_traits<A>::propagate_on_container_swap());
+	}
+
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::shares_allocator(const vector<T, A, G>& other) const {
+		return std::allocator_traits<A>::is_always_equal::value || allocator == other.allocator;
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::swap_buffers(vector<T, A, G>& other) noexcept {
 		std::swap(_begin, other._begin);
 		std::swap(_last, other._last);
 		std::swap(_end, other._end);
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::swap_allocator(vector<T, A, G>& other, std::true_type) {
 		std::swap(allocator, other.allocator);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::clear() noexcept {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::copy_allocator(const vector<T, A, G>& other, std::true_type) {
+		if (!(allocator == other.allocator)) {
+			destroy(begin(), end());
+			clear();
+		}
+		allocator = other.allocator;
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::move_allocator(vector<T, A, G>& other, std::true_type) {
+		allocator = std::move(other.allocator);
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::clear() noexcept {
 		allocator.deallocate(_begin, capacity());
 		_begin = _last = _end = nullptr;
 	}
 
-	template<typename T, typename A>
-	A vector<T, A>::get_allocator() const noexcept {
+	template<typename T, typename A, typename G>
+	A vector<T, A, G>::get_allocator() const noexcept {
 		return allocator;
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::resize(size_type new_size) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::resize(size_type new_size) {
 		size_type index = size();
-		if (new_size > capacity()) reallocate(new_size);
+		if (new_size > capacity()) reallocate(next_capacity(new_size));
 		_last = _begin + new_size;
 		if (index < size()) initialize(begin() + index, end());
 		else destroy(end(), begin() + index);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::resize(size_type new_size, const T& val) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::resize(size_type new_size, const T& val) {
 		erase(begin(), end());
 		assign(new_size, val);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::reserve(size_type new_size) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::reserve(size_type new_size) {
 		if (new_size > capacity()) reallocate(new_size);
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::shrink_to_fit() {
-		reallocate(size() / 2);
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::shrink_to_fit() {
+		reallocate(size());
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::size_type vector<T, A>::capacity() const noexcept {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::size_type vector<T, A, G>::capacity() const noexcept {
 		return _end - _begin;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::size_type vector<T, A>::size() const noexcept {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::size_type vector<T, A, G>::size() const noexcept {
 		return _last - _begin;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::size_type vector<T, A>::max_size() const noexcept {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::size_type vector<T, A, G>::max_size() const noexcept {
 		return (size_type)(-1) / sizeof(T);
 	}
 
-	template<typename T, typename A>
-	inline bool vector<T, A>::empty() const noexcept {
+	template<typename T, typename A, typename G>
+	inline bool vector<T, A, G>::empty() const noexcept {
 		return size() == 0;
 	}
 
-	template<typename T, typename A>
-	inline T& vector<T, A>::at(size_type i) {
+	template<typename T, typename A, typename G>
+	inline T& vector<T, A, G>::at(size_type i) {
 		if (i >= size()) throw std::out_of_range("vector subscript out of range");
 		return _begin[i];
 	}
 
-	template<typename T, typename A>
-	T& vector<T, A>::front() {
+	template<typename T, typename A, typename G>
+	T& vector<T, A, G>::front() {
 		return *(begin());
 	}
 
-	template<typename T, typename A>
-	T& vector<T, A>::back() {
+	template<typename T, typename A, typename G>
+	T& vector<T, A, G>::back() {
 		return *(end() - 1);
 	}
 
-	template<typename T, typename A>
-	T* vector<T, A>::data() noexcept {
+	template<typename T, typename A, typename G>
+	T* vector<T, A, G>::data() noexcept {
 		return _begin;
 	}
 
-	template<typename T, typename A>
-	T& vector<T, A>::operator[](size_type i) const {
+	template<typename T, typename A, typename G>
+	T& vector<T, A, G>::operator[](size_type i) const {
 		return _begin[i];
 	}
 
-	template<typename T, typename A>
-	inline void vector<T, A>::reallocate(size_type new_size) {
-		T* new_start = allocator.allocate(new_size * 2);
+	template<typename T, typename A, typename G>
+	inline void vector<T, A, G>::reallocate(size_type new_capacity) {
+		if (_begin) {
+			bool in_place = new_capacity > capacity()
+				? expand_in_place(allocator, _begin, capacity(), new_capacity)
+				: new_capacity >= size() && shrink_in_place(allocator, _begin, capacity(), new_capacity);
+			if (in_place) {
+				_end = _begin + new_capacity;
+				return;
+			}
+		}
+		T* new_start = allocator.allocate(new_capacity);
 		if (new_start == _begin) return;
+		size_type my_size = std::min(size(), new_capacity);
 		if (_begin) {
 			try {
-				std::copy(_begin, _begin + std::min(size(), new_size), new_start);
+				relocate(_begin, _begin + my_size, new_start, typename is_trivially_relocatable<T>::type());
 			}
 			catch (...) {
-				allocator.deallocate(new_start, new_size * 2);
+				allocator.deallocate(new_start, new_capacity);
 				throw exception();
 			}
+			destroy(begin() + my_size, end());
 			allocator.deallocate(_begin, capacity());
 		}
-		size_type my_size = size();
 		_begin = new_start;
 		_last = new_start + my_size;
-		_end = _begin + new_size * 2;
+		_end = _begin + new_capacity;
+	}
+
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::size_type vector<T, A, G>::next_capacity(size_type required) const {
+		return G::capacity(capacity(), required, sizeof(T));
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::relocate(T* first, T* last, T* destination, std::true_type) {
+		if (first != last) std::memcpy(static_cast<void*>(destination), static_cast<const void*>(first), (last - first) * sizeof(T));
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::relocate(T* first, T* last, T* destination, std::false_type) {
+		T* next = destination;
+		try {
+			for (T* it = first; it != last; ++it, ++next) allocator.construct(next, std::move_if_noexcept(*it));
+		}
+		catch (...) {
+			for (T* it = destination; it != next; ++it) allocator.destroy(it);
+			throw;
+		}
+		for (T* it = first; it != last; ++it) allocator.destroy(it);
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::shift(T* first, T* last, T* destination, std::true_type) {
+		if (first != last && destination != first) std::memmove(static_cast<void*>(destination), static_cast<const void*>(first), (last - first) * sizeof(T));
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::shift(T* first, T* last, T* destination, std::false_type) {
+		if (destination == first) return;
+		if (destination > first)
+			for (T* it = last; it-- != first;) {
+				allocator.construct(destination + (it - first), std::move(*it));
+				allocator.destroy(it);
+			}
+		else
+			for (T* it = first; it != last; ++it) {
+				allocator.construct(destination + (it - first), std::move(*it));
+				allocator.destroy(it);
+			}
+	}
+
+	template<typename T, typename A, typename G>
+	T* vector<T, A, G>::open_gap(size_type index, size_type n) {
+		if (n == 0) return _begin + index;
+		if (size() + n > capacity()) reallocate(next_capacity(size() + n));
+		T* gap = _begin + index;
+		shift(gap, _last, gap + n, typename is_trivially_relocatable<T>::type());
+		_last += n;
+		return gap;
+	}
+
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::close_gap(T* gap, size_type n, size_type built) {
+		if (n == 0) return;
+		for (T* it = gap; it != gap + built; ++it) allocator.destroy(it);
+		shift(gap + n, _last, gap, typename is_trivially_relocatable<T>::type());
+		_last -= n;
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::initialize(iterator first, iterator last) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::initialize(iterator first, iterator last) {
 		for (iterator it = first; it != last; ++it) allocator.construct(&*it, T());
 	}
 
-	template<typename T, typename A>
-	void vector<T, A>::destroy(iterator  first, iterator last) {
+	template<typename T, typename A, typename G>
+	void vector<T, A, G>::destroy(iterator  first, iterator last) {
 		for (iterator it = first; it != last; ++it) allocator.destroy(&*it);
 	}
 
-	template<typename T, typename A>
+	template<typename T, typename A, typename G>
 	template<typename ...Types>
-	typename vector<T, A>::iterator vector<T, A>::emplace(iterator& it, Types && ...args) {
-		size_type new_size = size() + 1;
+	typename vector<T, A, G>::iterator vector<T, A, G>::emplace(iterator& it, Types && ...args) {
 		size_type index = it - begin();
-		if (new_size > capacity()) reallocate(new_size);
-		it = begin() + index;
-		std::copy_backward(it, end(), it + size() - index + 1);
-		allocator.construct(&*it, std::forward<Types>(args)...);
-		return it;
+		if (index == size() && size() < capacity()) allocator.construct(_last++, std::forward<Types>(args)...);
+		else {
+			T value(std::forward<Types>(args)...);
+			T* gap = open_gap(index, 1);
+			try {
+				allocator.construct(gap, std::move(value));
+			}
+			catch (...) {
+				close_gap(gap, 1, 0);
+				throw;
+			}
+		}
+		return it = begin() + index;
 	}
 
-	template<typename T, typename A>
+	template<typename T, typename A, typename G>
 	template<typename ...Types>
-	typename vector<T, A>::iterator vector<T, A>::emplace_back(Types&& ...args) {
+	typename vector<T, A, G>::iterator vector<T, A, G>::emplace_back(Types&& ...args) {
 		return emplace(end(), std::forward<Types>(args)...);
 	}
 
-	template<typename T, typename A>
+	template<typename T, typename A, typename G>
 	template<typename InputIterator>
-	void vector<T, A>::assign(InputIterator first, InputIterator last) {
+	void vector<T, A, G>::assign(InputIterator first, InputIterator last) {
 		erase(begin(), end());
 		typename std::iterator_traits<InputIterator>::difference_type new_size = std::distance(first, last);
 		if (capacity() < new_size) reallocate(new_size);
@@ -432,107 +591,107 @@ namespace stl_compatible {
 		_last = _begin + new_size;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator& vector<T, A>::iterator::operator=(const iterator& other) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator& vector<T, A, G>::iterator::operator=(const iterator& other) {
 		ptr = other.ptr;
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator& vector<T, A>::iterator::operator++() {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator& vector<T, A, G>::iterator::operator++() {
 		++ptr;
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator& vector<T, A>::iterator::operator--() {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator& vector<T, A, G>::iterator::operator--() {
 		--ptr;
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::iterator::operator++(int) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::iterator::operator++(int) {
 		iterator temp(*this);
 		++ptr;
 		return temp;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::iterator::operator--(int) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::iterator::operator--(int) {
 		iterator temp(*this);
 		--ptr;
 		return temp;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator& vector<T, A>::iterator::operator+=(difference_type n) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator& vector<T, A, G>::iterator::operator+=(difference_type n) {
 		ptr += n;
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator& vector<T, A>::iterator::operator-=(difference_type n) {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator& vector<T, A, G>::iterator::operator-=(difference_type n) {
 		ptr -= n;
 		return *this;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator::difference_type vector<T, A>::iterator::operator-(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator::difference_type vector<T, A, G>::iterator::operator-(const iterator& other) const {
 		return ptr - other.ptr;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::iterator::operator+(difference_type n) const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::iterator::operator+(difference_type n) const {
 		return iterator(ptr + n);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator vector<T, A>::iterator::operator-(difference_type n) const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator vector<T, A, G>::iterator::operator-(difference_type n) const {
 		return iterator(ptr - n);
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator::reference vector<T, A>::iterator::operator*() const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator::reference vector<T, A, G>::iterator::operator*() const {
 		return *ptr;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator::pointer vector<T, A>::iterator::operator->() const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator::pointer vector<T, A, G>::iterator::operator->() const {
 		return ptr;
 	}
 
-	template<typename T, typename A>
-	typename vector<T, A>::iterator::reference vector<T, A>::iterator::operator[](difference_type i) const {
+	template<typename T, typename A, typename G>
+	typename vector<T, A, G>::iterator::reference vector<T, A, G>::iterator::operator[](difference_type i) const {
 		return ptr[i];
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator==(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator==(const iterator& other) const {
 		return ptr == other.ptr;
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator!=(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator!=(const iterator& other) const {
 		return !(*this == other);
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator>(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator>(const iterator& other) const {
 		return ptr > other.ptr;
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator<(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator<(const iterator& other) const {
 		return ptr < other.ptr;
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator>=(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator>=(const iterator& other) const {
 		return ptr >= other.ptr;
 	}
 
-	template<typename T, typename A>
-	bool vector<T, A>::iterator::operator<=(const iterator& other) const {
+	template<typename T, typename A, typename G>
+	bool vector<T, A, G>::iterator::operator<=(const iterator& other) const {
 		return ptr <= other.ptr;
 	}
 }
\ No newline at end of file